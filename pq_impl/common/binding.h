@@ -25,19 +25,19 @@
 
 #ifdef __CYGWIN__
 
-void binding_parseCustom(string argv) {}
+static void binding_parseCustom(string argv) {}
 
-int binding_getActualBinding(const int tid, const int nprocessors) {
+static int binding_getActualBinding(const int tid, const int nprocessors) {
     return -1;
 }
 
-bool binding_isInjectiveMapping(const int nthreads, const int nprocessors) {
+static bool binding_isInjectiveMapping(const int nthreads, const int nprocessors) {
     return true;
 }
 
-void binding_bindThread(const int tid, const int nprocessors) {}
+static void binding_bindThread(const int tid, const int nprocessors) {}
 
-void binding_configurePolicy(const int nprocessors) {}
+static void binding_configurePolicy(const int nprocessors) {}
 
 #else
 
@@ -117,7 +117,7 @@ static unsigned parseToken(string argv, int ix) {
 
 // argv contains a custom thread binding pattern, e.g., "1,2,3,8-11,4-7,0"
 // threads will be bound according to this binding
-void binding_parseCustom(string argv) {
+static void binding_parseCustom(string argv) {
     numCustomBindings = 0;
     
     unsigned ix = 0;
@@ -133,7 +133,7 @@ static void doBindThread(const int tid, const int nprocessors) {
     }
 }
 
-int binding_getActualBinding(const int tid, const int nprocessors) {
+static int binding_getActualBinding(const int tid, const int nprocessors) {
     int result = -1;
 #ifndef THREAD_BINDING
     if (numCustomBindings == 0) {
@@ -159,7 +159,7 @@ int binding_getActualBinding(const int tid, const int nprocessors) {
     return result;
 }
 
-bool binding_isInjectiveMapping(const int nthreads, const int nprocessors) {
+static bool binding_isInjectiveMapping(const int nthreads, const int nprocessors) {
 #ifndef THREAD_BINDING
     if (numCustomBindings == 0) {
         return true;
@@ -178,7 +178,7 @@ bool binding_isInjectiveMapping(const int nthreads, const int nprocessors) {
     return true;
 }
 
-void binding_bindThread(const int tid, const int nprocessors) {
+static void binding_bindThread(const int tid, const int nprocessors) {
     if (numCustomBindings == 0) {
 #ifdef THREAD_BINDING
         if (THREAD_BINDING != NONE) {
@@ -192,7 +192,7 @@ void binding_bindThread(const int tid, const int nprocessors) {
 
 // nthreads = 96
 // nprocessors = 256
-void binding_configurePolicy(const int nthreads, const int nprocessors) {
+static void binding_configurePolicy(const int nthreads, const int nprocessors) {
     // create cpu sets for binding threads to cores
     int size = CPU_ALLOC_SIZE(nprocessors);
     for (int i = 0; i < nprocessors; ++i) {
@@ -202,7 +202,7 @@ void binding_configurePolicy(const int nthreads, const int nprocessors) {
     }
 }
 
-void binding_deinit(const int nprocessors) {
+static void binding_deinit(const int nprocessors) {
     for (int i=0;i<nprocessors;++i) {
         CPU_FREE(cpusets[i]);
     }
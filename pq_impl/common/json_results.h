@@ -0,0 +1,121 @@
+/*
+ * File:   json_results.h
+ *
+ * Builds one flat-or-nested JSON object per trial and appends it as a single line to a results file (JSON Lines),
+ * so dashboards and plotting scripts can read runs without scraping stdout.
+ */
+
+#ifndef JSON_RESULTS_H
+#define	JSON_RESULTS_H
+
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+class json_record {
+private:
+    std::string body;
+
+    void add_key(const char * key) {
+        if (!body.empty()) body += ",";
+        body += "\"";
+        body += escape(key);
+        body += "\":";
+    }
+
+    static std::string escape(const std::string & s) {
+        std::string out;
+        for (char c : s) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char) c < 0x20) {
+                        char buf[8];
+                        snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out += buf;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+    }
+
+public:
+    json_record & add(const char * key, const std::string & value) {
+        add_key(key);
+        body += "\"" + escape(value) + "\"";
+        return *this;
+    }
+
+    json_record & add(const char * key, const char * value) {
+        return add(key, std::string(value ? value : ""));
+    }
+
+    json_record & add(const char * key, bool value) {
+        add_key(key);
+        body += (value ? "true" : "false");
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, json_record &>::type
+    add(const char * key, T value) {
+        add_key(key);
+        if (std::is_floating_point<T>::value && !std::isfinite((double) value)) {
+            body += "null"; // JSON has no nan/inf
+        } else {
+            body += std::to_string(value);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, json_record &>::type
+    add(const char * key, const std::vector<T> & values) {
+        add_key(key);
+        body += "[";
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i) body += ",";
+            body += std::to_string(values[i]);
+        }
+        body += "]";
+        return *this;
+    }
+
+    json_record & add(const char * key, const json_record & value) {
+        add_key(key);
+        body += value.str();
+        return *this;
+    }
+
+    json_record & add_null(const char * key) {
+        add_key(key);
+        body += "null";
+        return *this;
+    }
+
+    std::string str() const {
+        return "{" + body + "}";
+    }
+
+    // one write() of the whole line with O_APPEND, so records from concurrent runs do not interleave
+    bool append_to(const char * path) const {
+        int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        std::string line = str() + "\n";
+        bool ok = write(fd, line.data(), line.size()) == (ssize_t) line.size();
+        return (close(fd) == 0) && ok;
+    }
+};
+
+#endif	/* JSON_RESULTS_H */
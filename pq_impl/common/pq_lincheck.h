@@ -0,0 +1,117 @@
+/*
+ * File:   pq_lincheck.h
+ *
+ * Offline check that a recorded history (pq_trace.h, with invocation and response times) is consistent with a
+ * strict, linearizable priority queue. Deciding linearizability exactly is expensive, so this only reports
+ * violations that hold under every possible linearization:
+ *   order   - a delete-min returned k while a smaller key j was definitely in the queue: some copy of j finished
+ *             inserting before the delete-min was called, and no delete-min that could have removed it had been
+ *             called by the time this one returned
+ *   empty   - a delete-min reported an empty queue while some key was definitely in the queue
+ *   phantom - a delete-min returned a key more often than that key had been inserted by then
+ * A strict queue must have none of these; a relaxed queue (SMQ, SprayList) is expected to have order violations.
+ */
+
+#ifndef PQ_LINCHECK_H
+#define	PQ_LINCHECK_H
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "pq_trace.h"
+
+struct pq_lincheck_result {
+    long long delete_mins;
+    long long order;
+    long long empty;
+    long long phantom;
+    bool ok() const { return order == 0 && empty == 0 && phantom == 0; }
+};
+
+// works on a pq_trace_recorder or a pq_trace_reader; prints the first max_reports violations
+template <typename Trace>
+pq_lincheck_result pq_lincheck(const Trace & trace, int max_reports = 10) {
+    pq_lincheck_result result = {};
+    std::vector<const pq_trace_record *> inserts, deletes;
+    for (int tid = 0; tid < trace.threads(); ++tid) {
+        const pq_trace_record * records = trace.thread_records(tid);
+        for (uint64_t i = 0; i < trace.count(tid); ++i) {
+            (records[i].op == PQ_TRACE_DELETE_MIN ? deletes : inserts).push_back(&records[i]);
+        }
+    }
+    result.delete_mins = deletes.size();
+    int reports = 0;
+
+    // phantom: per key, the i-th delete-min response must come after the i-th insert invocation
+    std::vector<std::tuple<int64_t, uint64_t, int>> events; // (key, time, 0 = insert invoked / 1 = delete-min returned)
+    for (const pq_trace_record * r : inserts) events.emplace_back(r->key, r->invoke, 0);
+    for (const pq_trace_record * r : deletes) {
+        if (r->key != PQ_TRACE_EMPTY) events.emplace_back(r->key, r->time, 1);
+    }
+    std::sort(events.begin(), events.end());
+    long long available = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (i == 0 || std::get<0>(events[i]) != std::get<0>(events[i - 1])) available = 0;
+        if (std::get<2>(events[i]) == 0) {
+            ++available;
+        } else if (available > 0) {
+            --available;
+        } else {
+            ++result.phantom;
+            if (reports++ < max_reports) {
+                printf("lincheck: key %lld returned at %llu ns more times than it had been inserted\n",
+                        (long long) std::get<0>(events[i]), (unsigned long long) std::get<1>(events[i]));
+            }
+        }
+    }
+
+    // order / empty: sweep the delete-mins by invocation time, keeping per key the copies whose insert has returned
+    // minus those taken by delete-mins already called; the delete-mins called during this one are subtracted too
+    std::sort(inserts.begin(), inserts.end(), [](const pq_trace_record * a, const pq_trace_record * b) { return a->time < b->time; });
+    std::sort(deletes.begin(), deletes.end(), [](const pq_trace_record * a, const pq_trace_record * b) { return a->invoke < b->invoke; });
+    std::map<int64_t, long long> copies;
+    std::set<int64_t> present;
+    auto update = [&](int64_t key, long long delta) {
+        long long & c = copies[key];
+        c += delta;
+        if (c > 0) present.insert(key);
+        else present.erase(key);
+    };
+    size_t next_insert = 0;
+    for (size_t i = 0; i < deletes.size(); ++i) {
+        const pq_trace_record * d = deletes[i];
+        while (next_insert < inserts.size() && inserts[next_insert]->time < d->invoke) {
+            update(inserts[next_insert++]->key, 1);
+        }
+        size_t end = i + 1;
+        for (; end < deletes.size() && deletes[end]->invoke <= d->time; ++end) {
+            if (deletes[end]->key != PQ_TRACE_EMPTY) update(deletes[end]->key, -1);
+        }
+        if (!present.empty()) {
+            int64_t smallest = *present.begin();
+            if (d->key == PQ_TRACE_EMPTY) {
+                ++result.empty;
+                if (reports++ < max_reports) {
+                    printf("lincheck: thread %u delete-min [%llu, %llu] ns found the queue empty while key %lld was present\n",
+                            d->tid, (unsigned long long) d->invoke, (unsigned long long) d->time, (long long) smallest);
+                }
+            } else if (smallest < d->key) {
+                ++result.order;
+                if (reports++ < max_reports) {
+                    printf("lincheck: thread %u delete-min [%llu, %llu] ns returned %lld while key %lld was present\n",
+                            d->tid, (unsigned long long) d->invoke, (unsigned long long) d->time, (long long) d->key, (long long) smallest);
+                }
+            }
+        }
+        for (size_t j = i + 1; j < end; ++j) {
+            if (deletes[j]->key != PQ_TRACE_EMPTY) update(deletes[j]->key, 1);
+        }
+        if (d->key != PQ_TRACE_EMPTY) update(d->key, -1);
+    }
+    return result;
+}
+
+#endif	/* PQ_LINCHECK_H */
@@ -0,0 +1,197 @@
+/*
+ * File:   pq_trace.h
+ *
+ * Binary traces of priority queue operations. pq_trace_recorder logs each thread's inserts and delete-mins
+ * (thread, op, key, value, invocation and response timestamps) into a buffer owned by that thread and writes them
+ * all out at the end;
+ * pq_trace_reader mmaps a trace so the microbenchmark can replay it (-b 17).
+ *
+ * File layout: pq_trace_header, then num_threads uint64_t record counts, then each thread's records in order.
+ */
+
+#ifndef PQ_TRACE_H
+#define	PQ_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define PQ_TRACE_MAGIC "PQTRACE"
+#define PQ_TRACE_VERSION 2 // 2: records carry their invocation time
+#define PQ_TRACE_INSERT 0
+#define PQ_TRACE_DELETE_MIN 1 // key and value are what the delete-min returned; replay ignores them
+#define PQ_TRACE_PREFILL 2 // an insert made while prefilling, before the trace's time 0
+#define PQ_TRACE_EMPTY -1 // key of a delete-min that found the queue empty
+
+struct pq_trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_threads;
+};
+
+struct pq_trace_record {
+    uint64_t invoke; // ns since the recorder's start() when the op was called
+    uint64_t time; // ns since the recorder's start() when the op returned
+    int64_t key;
+    int64_t value;
+    uint32_t op;
+    uint32_t tid;
+};
+
+class pq_trace_recorder {
+private:
+    struct alignas(128) thread_buffer { // padded so threads never share a line while recording
+        std::vector<pq_trace_record> records;
+    };
+    thread_buffer * buffers;
+    int num_threads;
+    std::chrono::steady_clock::time_point start_time;
+
+public:
+    pq_trace_recorder(int num_threads, size_t reserve_per_thread) : num_threads(num_threads) {
+        buffers = new thread_buffer[num_threads];
+        for (int tid = 0; tid < num_threads; ++tid) {
+            buffers[tid].records.reserve(reserve_per_thread);
+        }
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    ~pq_trace_recorder() {
+        delete[] buffers;
+    }
+
+    // sets the time origin of the trace
+    void start() {
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    // ns since start(), for an op's invocation time
+    inline uint64_t now() const {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+        return (uint64_t) (ns > 0 ? ns : 0);
+    }
+
+    inline void record(int tid, uint32_t op, int64_t key, int64_t value, uint64_t invoke) {
+        buffers[tid].records.push_back({invoke, now(), key, value, op, (uint32_t) tid});
+    }
+
+    // for callers that do not time the invocation; it is taken to be the response
+    inline void record(int tid, uint32_t op, int64_t key, int64_t value) {
+        uint64_t t = now();
+        buffers[tid].records.push_back({t, t, key, value, op, (uint32_t) tid});
+    }
+
+    inline void record_prefill(int tid, int64_t key, int64_t value) {
+        buffers[tid].records.push_back({0, 0, key, value, PQ_TRACE_PREFILL, (uint32_t) tid});
+    }
+
+    int threads() const { return num_threads; }
+    uint64_t count(int tid) const { return buffers[tid].records.size(); }
+    const pq_trace_record * thread_records(int tid) const { return buffers[tid].records.data(); }
+
+    long long size() const {
+        long long total = 0;
+        for (int tid = 0; tid < num_threads; ++tid) total += buffers[tid].records.size();
+        return total;
+    }
+
+    // call once the recording threads are done
+    bool write(const char * path) const {
+        FILE * f = fopen(path, "wb");
+        if (f == NULL) {
+            return false;
+        }
+        pq_trace_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, PQ_TRACE_MAGIC, sizeof(header.magic));
+        header.version = PQ_TRACE_VERSION;
+        header.num_threads = num_threads;
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        for (int tid = 0; ok && tid < num_threads; ++tid) {
+            uint64_t count = buffers[tid].records.size();
+            ok = fwrite(&count, sizeof(count), 1, f) == 1;
+        }
+        for (int tid = 0; ok && tid < num_threads; ++tid) {
+            const std::vector<pq_trace_record> & records = buffers[tid].records;
+            ok = records.empty() || fwrite(records.data(), sizeof(pq_trace_record), records.size(), f) == records.size();
+        }
+        return (fclose(f) == 0) && ok;
+    }
+};
+
+class pq_trace_reader {
+private:
+    void * map;
+    size_t map_size;
+    int num_threads;
+    std::vector<uint64_t> counts;
+    std::vector<const pq_trace_record *> records;
+
+public:
+    pq_trace_reader() : map(NULL), map_size(0), num_threads(0) {}
+
+    ~pq_trace_reader() {
+        if (map != NULL) munmap(map, map_size);
+    }
+
+    // returns false (and prints why) if the file is missing or is not a complete trace
+    bool open(const char * path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            printf("trace: could not open %s\n", path);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(pq_trace_header)) {
+            printf("trace: %s is too small to be a trace\n", path);
+            close(fd);
+            return false;
+        }
+        map_size = st.st_size;
+        map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            map = NULL;
+            printf("trace: could not mmap %s\n", path);
+            return false;
+        }
+        madvise(map, map_size, MADV_SEQUENTIAL);
+
+        const pq_trace_header * header = (const pq_trace_header *) map;
+        if (memcmp(header->magic, PQ_TRACE_MAGIC, sizeof(header->magic)) != 0 || header->version != PQ_TRACE_VERSION) {
+            printf("trace: %s is not a version %d trace\n", path, PQ_TRACE_VERSION);
+            return false;
+        }
+        num_threads = header->num_threads;
+        size_t expected = sizeof(pq_trace_header) + num_threads * sizeof(uint64_t);
+        if (map_size < expected) {
+            printf("trace: %s is truncated\n", path);
+            return false;
+        }
+        const uint64_t * header_counts = (const uint64_t *) (header + 1);
+        const pq_trace_record * next = (const pq_trace_record *) (header_counts + num_threads);
+        for (int tid = 0; tid < num_threads; ++tid) {
+            counts.push_back(header_counts[tid]);
+            records.push_back(next);
+            next += header_counts[tid];
+            expected += header_counts[tid] * sizeof(pq_trace_record);
+        }
+        if (map_size != expected) {
+            printf("trace: %s has %zu bytes, expected %zu\n", path, map_size, expected);
+            return false;
+        }
+        return true;
+    }
+
+    int threads() const { return num_threads; }
+    uint64_t count(int tid) const { return counts[tid]; }
+    const pq_trace_record * thread_records(int tid) const { return records[tid]; }
+};
+
+#endif	/* PQ_TRACE_H */
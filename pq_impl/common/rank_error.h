@@ -0,0 +1,117 @@
+/*
+ * File:   rank_error.h
+ *
+ * Quality of a (possibly relaxed) priority queue, computed offline from an operation trace (pq_trace.h).
+ * The threads' records are merged by timestamp and replayed against an exact multiset of the keys present:
+ *   rank  - for each delete-min, how many smaller keys were in the queue (0 for a strict queue)
+ *   delay - for each minimum, how many delete-mins returned something else while it was the minimum
+ * Timestamps are taken when an operation returns, so ops that overlap in time can be ordered either way;
+ * expect small nonzero ranks even for strict queues under contention.
+ */
+
+#ifndef RANK_ERROR_H
+#define	RANK_ERROR_H
+
+#include <algorithm>
+#include <vector>
+#include "pq_trace.h"
+
+struct rank_error_stats {
+    long long delete_mins;  // non-empty delete-mins that were ranked
+    long long unmatched;    // delete-mins whose key was not present at their timestamp (overlapping insert)
+    double rank_mean;
+    long long rank_p50;
+    long long rank_p90;
+    long long rank_p99;
+    long long rank_max;
+    double delay_mean;
+    long long delay_max;
+};
+
+// works on a pq_trace_recorder or a pq_trace_reader
+template <typename Trace>
+rank_error_stats rank_error_analyze(const Trace & trace) {
+    rank_error_stats stats = {};
+    std::vector<pq_trace_record> events;
+    std::vector<int64_t> keys;
+    for (int tid = 0; tid < trace.threads(); ++tid) {
+        const pq_trace_record * records = trace.thread_records(tid);
+        for (uint64_t i = 0; i < trace.count(tid); ++i) {
+            events.push_back(records[i]);
+            if (records[i].op != PQ_TRACE_DELETE_MIN) keys.push_back(records[i].key);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const pq_trace_record & a, const pq_trace_record & b) { return a.time < b.time; });
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // fenwick tree over the distinct keys, counting the copies of each key in the queue
+    const int n = keys.size();
+    std::vector<long long> tree(n + 1, 0);
+    std::vector<long long> copies(n, 0);
+    std::vector<long long> skips(n, 0); // delete-mins that passed over the key while it was the minimum
+    int log_n = 1;
+    while ((1 << log_n) <= n) ++log_n;
+    auto update = [&](int ix, long long delta) {
+        copies[ix] += delta;
+        for (++ix; ix <= n; ix += ix & -ix) tree[ix] += delta;
+    };
+    auto smaller = [&](int ix) { // copies of keys below keys[ix]
+        long long sum = 0;
+        for (; ix > 0; ix -= ix & -ix) sum += tree[ix];
+        return sum;
+    };
+    auto minimum = [&]() { // index of the smallest present key; only valid if the queue is not empty
+        int pos = 0;
+        for (int step = 1 << log_n; step > 0; step >>= 1) {
+            if (pos + step <= n && tree[pos + step] == 0) pos += step;
+        }
+        return pos;
+    };
+
+    std::vector<long long> ranks;
+    long long delays = 0;
+    long long delay_samples = 0;
+    for (const pq_trace_record & e : events) {
+        if (e.op != PQ_TRACE_DELETE_MIN) {
+            update(std::lower_bound(keys.begin(), keys.end(), e.key) - keys.begin(), 1);
+            continue;
+        }
+        if (e.key == PQ_TRACE_EMPTY) {
+            continue;
+        }
+        auto it = std::lower_bound(keys.begin(), keys.end(), e.key);
+        int ix = it - keys.begin();
+        if (it == keys.end() || *it != e.key || copies[ix] == 0) {
+            ++stats.unmatched;
+            continue;
+        }
+        int min_ix = minimum();
+        if (min_ix == ix) {
+            delays += skips[ix];
+            stats.delay_max = std::max(stats.delay_max, skips[ix]);
+            ++delay_samples;
+            skips[ix] = 0;
+        } else {
+            ++skips[min_ix];
+        }
+        ranks.push_back(smaller(ix));
+        update(ix, -1);
+    }
+
+    stats.delete_mins = ranks.size();
+    if (!ranks.empty()) {
+        std::sort(ranks.begin(), ranks.end());
+        long long sum = 0;
+        for (long long r : ranks) sum += r;
+        stats.rank_mean = (double) sum / ranks.size();
+        stats.rank_p50 = ranks[(ranks.size() - 1) * 50 / 100];
+        stats.rank_p90 = ranks[(ranks.size() - 1) * 90 / 100];
+        stats.rank_p99 = ranks[(ranks.size() - 1) * 99 / 100];
+        stats.rank_max = ranks.back();
+    }
+    stats.delay_mean = (delay_samples ? (double) delays / delay_samples : 0);
+    return stats;
+}
+
+#endif	/* RANK_ERROR_H */
@@ -161,6 +161,8 @@ namespace stats_ns {
             int offset[MAX_NUM_STATS];
             int capacity[MAX_NUM_STATS];
             int size[MAX_NUM_STATS];
+            long long seen[MAX_NUM_STATS]; // values offered to sample_stat, kept or not
+            unsigned long long sample_rng; // xorshift state of sample_stat
             volatile char * padding1[STATS_THREAD_PADDING_BYTES];
             
             template <typename T>
@@ -347,6 +349,7 @@ namespace stats_ns {
                     memset(thread_data[tid].data + thread_data[tid].offset[id], 0, DATA_SIZE_BYTES*thread_data[tid].size[id]);
                 }
                 memset(thread_data[tid].size, 0, sizeof(int)*MAX_NUM_STATS);
+                memset(thread_data[tid].seen, 0, sizeof(long long)*MAX_NUM_STATS);
             }
             for (stat_id id=0;id<num_stats;++id) {
                 computed_stats_total[id] = NULL;
@@ -431,6 +434,33 @@ namespace stats_ns {
             return value;
         }
         
+        // like append_stat, but once the stat is full each new value replaces a random entry (reservoir sampling),
+        // so the entries stay a uniform sample of every value offered rather than the first capacity values
+        template <typename T>
+        inline T sample_stat(const int tid, const stat_id id, T value) {
+            long long seen = ++thread_data[tid].seen[id];
+            int index = thread_data[tid].size[id];
+            if (index < thread_data[tid].capacity[id]) {
+                thread_data[tid].get_ptr<T>(id)[index] = value;
+                ++thread_data[tid].size[id];
+                return value;
+            }
+            unsigned long long x = thread_data[tid].sample_rng;
+            if (x == 0) x = 0x9E3779B97F4A7C15ULL + tid;
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            thread_data[tid].sample_rng = x;
+            unsigned long long j = (unsigned long long) (((unsigned __int128) x * seen) >> 64); // uniform in [0, seen)
+            if (j < (unsigned long long) thread_data[tid].capacity[id]) {
+                thread_data[tid].get_ptr<T>(id)[j] = value;
+            }
+            return value;
+        }
+        
+        // number of entries thread tid has appended/set for this stat
+        inline int get_size(const int tid, const stat_id id) {
+            return thread_data[tid].size[id];
+        }
+        
         template <typename T>
         inline T get_stat(const int tid, const stat_id id, const int index) {
             if (index >= thread_data[tid].capacity[id]) {
@@ -84,8 +84,10 @@ extern stats& GSTATS_OBJECT_NAME;
 #define GSTATS_GET_IX_D(tid, stat, index) GSTATS_OBJECT_NAME.get_stat<double>(tid, stat, index)
 #define GSTATS_GET(tid, stat) GSTATS_OBJECT_NAME.get_stat<long long>(tid, stat, 0)
 #define GSTATS_GET_D(tid, stat) GSTATS_OBJECT_NAME.get_stat<double>(tid, stat, 0)
+#define GSTATS_GET_SIZE(tid, stat) GSTATS_OBJECT_NAME.get_size(tid, stat)
 #define GSTATS_APPEND(tid, stat, val) GSTATS_OBJECT_NAME.append_stat<long long>(tid, stat, val)
 #define GSTATS_APPEND_D(tid, stat, val) GSTATS_OBJECT_NAME.append_stat<double>(tid, stat, val)
+#define GSTATS_SAMPLE(tid, stat, val) GSTATS_OBJECT_NAME.sample_stat<long long>(tid, stat, val)
 #define GSTATS_GET_STAT_METRICS(stat, aggregation_granularity) GSTATS_OBJECT_NAME.compute_stat_metrics<long long>(stat, aggregation_granularity)
 #define GSTATS_GET_STAT_METRICS_D(stat, aggregation_granularity) GSTATS_OBJECT_NAME.compute_stat_metrics<long long>(stat, aggregation_granularity)
 #define GSTATS_CLEAR_ALL GSTATS_OBJECT_NAME.clear_all()
@@ -104,6 +106,7 @@ extern stats& GSTATS_OBJECT_NAME;
 })
 #define GSTATS_TIMER_APPEND_ELAPSED(tid, timer_stat, target_stat) GSTATS_APPEND(tid, target_stat, GSTATS_TIMER_ELAPSED(tid, timer_stat))
 #define GSTATS_TIMER_APPEND_SPLIT(tid, timer_stat, target_stat) GSTATS_APPEND(tid, target_stat, GSTATS_TIMER_SPLIT(tid, timer_stat))
+#define GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_stat, target_stat) GSTATS_SAMPLE(tid, target_stat, GSTATS_TIMER_ELAPSED(tid, timer_stat))
 
 /**
  * External declarations
@@ -140,8 +143,10 @@ GSTATS_DECLARE_EXTERN_ALL_STAT_IDS;
 #define GSTATS_GET_IX_D(tid, stat, index) 
 #define GSTATS_GET(tid, stat) 
 #define GSTATS_GET_D(tid, stat) 
+#define GSTATS_GET_SIZE(tid, stat) 0
 #define GSTATS_APPEND(tid, stat, val) 
 #define GSTATS_APPEND_D(tid, stat, val) 
+#define GSTATS_SAMPLE(tid, stat, val) 
 #define GSTATS_CLEAR_ALL 
 #define GSTATS_PRINT 
 
@@ -153,6 +158,7 @@ GSTATS_DECLARE_EXTERN_ALL_STAT_IDS;
 #define GSTATS_TIMER_SPLIT(tid, timer_stat) 
 #define GSTATS_TIMER_APPEND_ELAPSED(tid, timer_stat, target_stat) 
 #define GSTATS_TIMER_APPEND_SPLIT(tid, timer_stat, target_stat) 
+#define GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_stat, target_stat) 
 
 #endif
 
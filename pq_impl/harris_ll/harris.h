@@ -91,7 +91,7 @@ void set_destroy(intset_t *set);
 long set_size(intset_t *set);
 long long set_keysum(intset_t *set);
 void print_set(intset_t *set);
-int set_validate(intset_t *set, int largest_per_idx[96]);
+int set_validate(intset_t *set, int largest_per_idx[], int zone_slots); // largest key per slot, at zone * zone_slots + idx
 
 /* ################################################################### *
  * ADAPTED HARRIS' LINKED LIST
@@ -100,12 +100,14 @@ int set_validate(intset_t *set, int largest_per_idx[96]);
 // search methods
 node__t *harris_search(intset_t *set, k_t key, node__t **left_node);
 node__t *harris_search_idx(intset_t *set, int idx, int zone, node__t **left_node);
+node__t *harris_search_kv(intset_t *set, k_t key, val__t val, node__t **left_node);
 void harris_search_physdel(intset_t *set, node__t* search_node);
 
 // interface methods
 int harris_insert(intset_t *set, LeaderLargest* last_ptr, int idx, int zone, k_t key, val__t val);
 val__t harris_delete_idx(intset_t *set, int idx, int zone, k_t* key);
 val__t linden_delete_min(intset_t *set, k_t* del_key, int* del_idx, int* del_zone);
+node__t *harris_remove(intset_t *set, k_t key, val__t val, int* idx, int* zone); // caller excludes linden_delete_min
 
 // methods that track a pointer to the last log deleted node - slower with one leader, faster with 4 (both cases due to numa locality + cache misses)
 node__t *opt_harris_search(intset_t *set, k_t key, node__t **left_node);
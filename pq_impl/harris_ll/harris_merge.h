@@ -0,0 +1,125 @@
+/*
+ * File:
+ *   harris_merge.h
+ * Description:
+ *   Operations on the PIPQ leader list while no other thread can change it (meld, restore, remove).
+ *   Per-slot results are indexed zone * NUMA_ZONE_THREADS + idx, so this is included after
+ *   pipq_strict.h, which defines the layout.
+ */
+
+#ifndef HARRIS_MERGE_H
+#define HARRIS_MERGE_H
+
+#include <cstdlib>
+#include <vector>
+
+/*
+ * set_merge moves the unmarked nodes of other into set in a single pass over both (sorted) lists,
+ * leaving other empty. Logically deleted nodes of either list are freed along the way. Fills the
+ * largest node and the node count per slot of the merged list.
+ * The leader holds each key once: a node whose key is already in the merged list is not linked but
+ * appended to rejected, re-tagged with the (zone, idx) of the node it collided with.
+ */
+inline void set_merge(intset_t *set, intset_t *other, node__t *largest_per_idx[], int count_per_idx[], std::vector<node__t*> &rejected) {
+  node__t *last = set->head;
+  node__t *a = set->head->next;
+  node__t *b = other->head->next;
+
+  for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+	largest_per_idx[i] = nullptr;
+	count_per_idx[i] = 0;
+  }
+
+  while (1) {
+	while ((node__t*)get_unmarked_reference(a) != set->tail && is_marked_reference(a)) {
+		node__t* tmp = (node__t*)get_unmarked_reference(a);
+		a = tmp->next;
+		free(tmp);
+	}
+	while ((node__t*)get_unmarked_reference(b) != other->tail && is_marked_reference(b)) {
+		node__t* tmp = (node__t*)get_unmarked_reference(b);
+		b = tmp->next;
+		free(tmp);
+	}
+	bool a_done = (node__t*)get_unmarked_reference(a) == set->tail;
+	bool b_done = (node__t*)get_unmarked_reference(b) == other->tail;
+	if (a_done && b_done) break;
+
+	node__t *take;
+	if (b_done || (!a_done && a->key <= b->key)) {
+		take = a;
+		a = a->next;
+	} else {
+		take = b;
+		b = b->next;
+	}
+	if (last != set->head && take->key == last->key) {
+		take->idx = last->idx;
+		take->zone = last->zone;
+		rejected.push_back(take);
+		continue;
+	}
+	last->next = take;
+	last = take;
+	largest_per_idx[take->zone * NUMA_ZONE_THREADS + take->idx] = take;
+	count_per_idx[take->zone * NUMA_ZONE_THREADS + take->idx]++;
+  }
+  last->next = set->tail;
+  set->last_log_del = nullptr;
+  other->head->next = other->tail;
+  other->last_log_del = nullptr;
+}
+
+/*
+ * set_trim unlinks the nodes of each slot whose key is above trim_above[slot] and appends them to
+ * trimmed, freeing logically deleted nodes. Refills the largest node and node count per slot.
+ */
+inline void set_trim(intset_t *set, const k_t trim_above[], node__t *largest_per_idx[], int count_per_idx[], std::vector<node__t*> &trimmed) {
+  node__t *last = set->head;
+  node__t *node = set->head->next;
+
+  for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+	largest_per_idx[i] = nullptr;
+	count_per_idx[i] = 0;
+  }
+
+  while ((node__t*)get_unmarked_reference(node) != set->tail) {
+	node__t* cur = (node__t*)get_unmarked_reference(node);
+	bool marked = is_marked_reference(node);
+	node = cur->next;
+	if (marked) {
+		free(cur);
+		continue;
+	}
+	int slot = cur->zone * NUMA_ZONE_THREADS + cur->idx;
+	if (cur->key > trim_above[slot]) {
+		trimmed.push_back(cur);
+		continue;
+	}
+	last->next = cur;
+	last = cur;
+	largest_per_idx[slot] = cur;
+	count_per_idx[slot]++;
+  }
+  last->next = set->tail;
+  set->last_log_del = nullptr;
+}
+
+/*
+ * set_last_of_slot returns the largest unmarked node of slot (zone, idx), or nullptr if the slot has
+ * none - the new largest ptr of a slot whose largest node was removed.
+ */
+inline node__t *set_last_of_slot(intset_t *set, int idx, int zone) {
+  node__t *last = nullptr;
+  node__t *node = set->head->next;
+  while ((node__t*)get_unmarked_reference(node) != set->tail) {
+	node__t* cur = (node__t*)get_unmarked_reference(node);
+	if (!is_marked_reference(node) && !is_marked_reference(cur->next) && cur->idx == idx && cur->zone == zone) {
+		last = cur;
+	}
+	node = cur->next;
+  }
+  return last;
+}
+
+#endif /* HARRIS_MERGE_H */
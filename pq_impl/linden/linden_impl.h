@@ -536,8 +536,10 @@ pq_t* linden_ns::linden::pq_init() {
   h->level = NUM_LEVELS;
   t->level = NUM_LEVELS;
 
-  for (i = 0; i < NUM_LEVELS; i++)
+  for (i = 0; i < NUM_LEVELS; i++) {
     h->next[i] = t;
+    t->next[i] = NULL; // read (as unmarked) when a search reaches the tail
+  }
 
   pq = (pq_t *)malloc(sizeof *pq);
   pq->head = h;
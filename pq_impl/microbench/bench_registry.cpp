@@ -0,0 +1,80 @@
+/*
+ * File:   bench_registry.cpp
+ *
+ * Entry point of the multi-structure benchmark binary (make pqbench): "-ds <name>" picks the data structure at runtime,
+ * through the run entry of that structure (pq_adapter.h). Each entry runs the timed mixed workload of main.cpp's
+ * benchmark 3 with uniform keys (pq_workload.h), compiled against that structure. The other workloads stay in the
+ * per-structure executables (make pipq, linden, ...).
+ *
+ * Usage: pqbench -ds <name> [-n threads] [-t millis] [-i insert percent] [-k max key] [-p prefill]
+ *                [-h heap list size] [-m max offset] [-bind pattern]
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "pq_adapter.h"
+
+using namespace std;
+
+struct bench_entry {
+    const char * name;
+    pq_bench_entry run;
+};
+
+const bench_entry BENCH_REGISTRY[] = {
+    {"pipq", run_pipq_bench},
+    {"linden", run_linden_bench},
+    {"lotan", run_lotan_bench},
+    {"smq", run_smq_bench},
+    {"cbpq", NULL}, // ChunkBasedPQ does not build in this tree (see the commented-out ChunkedPQ target)
+};
+
+int main(int argc, char** argv) {
+    const char * ds = NULL;
+    pq_adapter_config config = {1, 1000000, 1000000, 0, NULL}; // main.cpp's defaults
+    pq_workload_config workload = {3000, 50, 1000000};
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 == argc) {
+            cout<<"missing value for "<<argv[i]<<endl;
+            return 1;
+        } else if (strcmp(argv[i], "-ds") == 0) {
+            ds = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            workload.millis = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0) {
+            workload.ins_percent = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0) {
+            config.max_key = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            workload.prefill = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0) {
+            config.heap_list_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0) {
+            config.max_offset = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-bind") == 0) { // e.g., "-bind 1,2,3,8-11,4-7,0"
+            config.binding = argv[++i];
+        } else {
+            cout<<"bad argument "<<argv[i]<<endl;
+            return 1;
+        }
+    }
+
+    for (const bench_entry & entry : BENCH_REGISTRY) {
+        if (ds && strcmp(ds, entry.name) == 0) {
+            if (!entry.run) {
+                cout<<"data structure "<<ds<<" is not built into this binary"<<endl;
+                return 1;
+            }
+            return entry.run(config, workload);
+        }
+    }
+    cout<<"Must pass a data structure (-ds), one of:";
+    for (const bench_entry & entry : BENCH_REGISTRY) {
+        if (entry.run) cout<<" "<<entry.name;
+    }
+    cout<<endl;
+    return 1;
+}
@@ -42,6 +42,22 @@ int DELMIN_THREADS_PER_ZONE;
 int COUNTER_TSH;
 int COUNTER_MX;
 int LMAX_OFFSET;
+double OPEN_LOOP_RATE; // target aggregate ops/sec for the open-loop benchmark
+int OPEN_LOOP_ARRIVAL; // 0 - fixed inter-arrival times, 1 - poisson arrivals
+int HOLD_DIST; // hold model increment distribution: 0 - exponential, 1 - uniform, 2 - bimodal, 3 - triangular
+int HOLD_MEAN; // mean hold model increment
+int DES_LPS; // number of logical processes in the PHOLD benchmark
+int DES_EVENT_WORK; // busy-work iterations per PHOLD event
+int KEY_DIST; // key distribution used by the workloads (see key_distribution.h)
+double KEY_DIST_PARAM; // distribution parameter, negative for the distribution's default
+int TIMELINE_INTERVAL_MS; // if positive, ops are also counted per interval of this many ms (see timeline_record)
+string TRACE_RECORD; // if set, the ops of benchmark 3 are recorded to this trace file
+string TRACE_REPLAY; // trace file replayed by benchmark 17
+bool TRACE_REPLAY_TIMING; // replay ops no earlier than their recorded time offsets
+bool RANK_ERROR; // trace benchmark 3 in memory and report the rank error of its delete-mins (see rank_error.h)
+bool LINCHECK; // trace benchmark 3 in memory and check its history against a strict priority queue (see pq_lincheck.h)
+string JSON_OUTPUT; // if set, one JSON record per trial is appended to this file
+string DS_NAME;
 
 /**
  * Configure global statistics using stats_global.h and stats.h
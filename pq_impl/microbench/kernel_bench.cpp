@@ -0,0 +1,365 @@
+/*
+ * File:   kernel_bench.cpp
+ *
+ * Single-threaded benchmark of the PIPQ kernels, outside of main.cpp (no thread pinning, NUMA zones or PAPI):
+ *   worker - insert_worker / delete_min_worker on one worker heap, by heap size; the sizes include the
+ *            HEAP_LIST_SIZE chunk boundaries. At size n the insert fills slot n and the delete-min that follows
+ *            empties it again, so both ops touch the chunk holding slot n.
+ *   leader - harris_insert / linden_delete_min on the leader list, by list length (random keys, so an insert
+ *            walks half of the list on average)
+ *   move   - harris_insert_and_move on the leader list, by list length: a worker inserts a key below its largest
+ *            key in the leader and that largest key is unlinked (the keys belong to 24 workers)
+ * Each op is timed on its own with get_server_clock() and the timer's own cost is subtracted. Cache misses
+ * (L1D read and last level) are counted with perf_event_open in a separate pass over the same kernel, so the timed
+ * loop makes no syscalls: the counters are enabled around batches of KERNEL_MISS_BATCH ops of one kind (which moves
+ * the heap size or list length by up to a batch). They are shown as n/a where the kernel does not allow them.
+ *
+ * Usage: kernels [-h heap list size] [-heap max heap size] [-leader max leader length] [-o ops per size] [-m max offset]
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+#include "../common/server_clock.h"
+#include "../recordmgr/debugprinting.h"
+#include "pipq_strict_impl.h"
+
+using namespace pq_ns;
+
+#ifndef SOFTWARE_BARRIER
+#define SOFTWARE_BARRIER asm volatile("": : :"memory")
+#endif
+
+#define KERNEL_WORKERS 24 // workers per zone owning leader keys in the move kernel
+#define KERNEL_KEY_RANGE (1 << 30)
+#define KERNEL_MISS_BATCH 32 // ops per counter start/stop in the cache miss passes
+
+// cache misses of the calling thread between start() and stop(), user space only
+class cache_counters {
+private:
+    int fds[2];
+
+    static int open_counter(uint32_t type, uint64_t config) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+public:
+    cache_counters() {
+        fds[0] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    }
+
+    ~cache_counters() {
+        for (int fd : fds) if (fd >= 0) close(fd);
+    }
+
+    bool available(int i) const { return fds[i] >= 0; }
+
+    void start() {
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // adds the misses since start() to totals
+    void stop(long long totals[2]) {
+        for (int i = 0; i < 2; ++i) {
+            long long value = 0;
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fds[i], &value, sizeof(value)) == sizeof(value)) totals[i] += value;
+        }
+    }
+};
+
+struct kernel_result {
+    long long ops;
+    uint64_t ns; // timer cost is subtracted when printed
+    long long misses[2]; // L1D read, last level
+};
+
+static cache_counters * counters;
+static double timer_ns; // cost of one get_server_clock() pair
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+
+static inline int next_key() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return 1 + (int) (rng_state % (KERNEL_KEY_RANGE - 1));
+}
+
+static void calibrate_timer() {
+    const int reps = 1000000;
+    uint64_t total = 0;
+    for (int i = 0; i < reps; ++i) {
+        uint64_t t0 = get_server_clock();
+        SOFTWARE_BARRIER;
+        uint64_t t1 = get_server_clock();
+        total += t1 - t0;
+    }
+    timer_ns = (double) total / reps;
+}
+
+static void print_header(const char * kernel, const char * size) {
+    printf("\n%-8s %10s %-12s %10s %12s %12s\n", kernel, size, "op", "ns/op", "L1D miss/op", "LLC miss/op");
+}
+
+static void print_result(const char * kernel, long long size, const char * op, const kernel_result & r) {
+    double ns = (double) r.ns / r.ops - timer_ns;
+    printf("%-8s %10lld %-12s %10.1f", kernel, size, op, ns > 0 ? ns : 0);
+    for (int i = 0; i < 2; ++i) {
+        if (counters->available(i)) printf(" %12.3f", (double) r.misses[i] / r.ops);
+        else printf(" %12s", "n/a");
+    }
+    printf("\n");
+}
+
+// sizes 1, 2, 4, ... up to max, plus the slots on either side of the first chunk boundaries
+static std::vector<long long> heap_sizes(long long max, int hls) {
+    std::vector<long long> sizes;
+    for (long long n = 1; n <= max; n *= 2) sizes.push_back(n);
+    for (long long k = 1; k <= 4; ++k) {
+        for (long long n = k * hls - 1; n <= k * hls + 1; ++n) {
+            if (n >= 1 && n <= max) sizes.push_back(n);
+        }
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    return sizes;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      WORKER HEAP                             */
+/*                                                              */
+/*         --------------------------------------------         */
+
+static void bench_worker(pq<long long> * q, long long max_size, long long ops, int hls) {
+    pq<long long>::PQ_Heap * heap;
+    q->HeapInit(&heap, 0, hls);
+    print_header("worker", "heap size");
+    for (long long n : heap_sizes(max_size, hls)) {
+        int key;
+        while (heap->size < n) {
+            int k = next_key();
+            q->insert_worker(heap, k, k);
+        }
+        kernel_result ins = {ops, 0, {0, 0}};
+        kernel_result del = {ops, 0, {0, 0}};
+        for (long long i = 0; i < ops; ++i) {
+            int k = next_key();
+            uint64_t t0 = get_server_clock();
+            q->insert_worker(heap, k, k);
+            uint64_t t1 = get_server_clock();
+            ins.ns += t1 - t0;
+
+            t0 = get_server_clock();
+            q->delete_min_worker(heap, &key);
+            t1 = get_server_clock();
+            del.ns += t1 - t0;
+        }
+        for (long long done = 0; done < ops; done += KERNEL_MISS_BATCH) {
+            long long batch = std::min<long long>(KERNEL_MISS_BATCH, ops - done);
+            counters->start();
+            for (long long i = 0; i < batch; ++i) {
+                int k = next_key();
+                q->insert_worker(heap, k, k);
+            }
+            counters->stop(ins.misses);
+            counters->start();
+            for (long long i = 0; i < batch; ++i) {
+                q->delete_min_worker(heap, &key);
+            }
+            counters->stop(del.misses);
+        }
+        print_result("worker", n, "insert", ins);
+        print_result("worker", n, "delete_min", del);
+    }
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      LEADER LIST                             */
+/*                                                              */
+/*         --------------------------------------------         */
+
+// a leader list holding len random keys of KERNEL_WORKERS workers; inserted in descending order so each insert is O(1)
+static intset_t * build_leader(long long len, int offset, LeaderLargest * largest) {
+    intset_t * set = set_new(offset);
+    for (int w = 0; w < KERNEL_WORKERS; ++w) largest[w].largest_ptr = NULL;
+    std::vector<int> keys(len);
+    for (long long i = 0; i < len; ++i) keys[i] = next_key();
+    std::sort(keys.begin(), keys.end(), std::greater<int>());
+    for (long long i = 0; i < len; ++i) {
+        int w = i % KERNEL_WORKERS;
+        harris_insert(set, &largest[w], w, 0, keys[i], keys[i]);
+    }
+    return set;
+}
+
+// linden_delete_min, clearing the worker's largest ptr when its last key leaves the leader
+static inline void leader_delete_min(intset_t * set, LeaderLargest * largest) {
+    k_t del_key;
+    int del_idx, del_zone;
+    linden_delete_min(set, &del_key, &del_idx, &del_zone);
+    if (del_key != EMPTY && largest[del_idx].largest_ptr && largest[del_idx].largest_ptr->key == del_key) {
+        largest[del_idx].largest_ptr = NULL;
+    }
+}
+
+static void bench_leader(long long max_len, long long ops, int offset) {
+    LeaderLargest largest[KERNEL_WORKERS];
+    print_header("leader", "length");
+    for (long long len = 1; len <= max_len; len *= 2) {
+        intset_t * set = build_leader(len, offset, largest);
+        kernel_result ins = {ops, 0, {0, 0}};
+        kernel_result del = {ops, 0, {0, 0}};
+        for (long long i = 0; i < ops; ++i) {
+            int k = next_key();
+            int w = i % KERNEL_WORKERS;
+            uint64_t t0 = get_server_clock();
+            harris_insert(set, &largest[w], w, 0, k, k);
+            uint64_t t1 = get_server_clock();
+            ins.ns += t1 - t0;
+
+            t0 = get_server_clock();
+            leader_delete_min(set, largest);
+            t1 = get_server_clock();
+            del.ns += t1 - t0;
+        }
+        for (long long done = 0; done < ops; done += KERNEL_MISS_BATCH) {
+            long long batch = std::min<long long>(KERNEL_MISS_BATCH, ops - done);
+            counters->start();
+            for (long long i = 0; i < batch; ++i) {
+                int k = next_key();
+                int w = (done + i) % KERNEL_WORKERS;
+                harris_insert(set, &largest[w], w, 0, k, k);
+            }
+            counters->stop(ins.misses);
+            counters->start();
+            for (long long i = 0; i < batch; ++i) {
+                leader_delete_min(set, largest);
+            }
+            counters->stop(del.misses);
+        }
+        print_result("leader", len, "insert", ins);
+        print_result("leader", len, "delete_min", del);
+        set_destroy(set);
+    }
+}
+
+// ops moves on a list of length len; each move lowers the mover's largest key, so the list is rebuilt (untimed)
+// after every len moves. Times each move, or with count_misses counts the cache misses of batches of moves instead.
+static void run_moves(long long len, long long ops, int offset, bool count_misses, kernel_result & move) {
+    LeaderLargest largest[KERNEL_WORKERS];
+    intset_t * set = NULL;
+    long long since_build = len;
+    long long batch = 0; // moves since counters->start(), if counting
+    long long done = 0;
+    while (done < ops) {
+        if (since_build == len) {
+            if (batch > 0) {
+                counters->stop(move.misses);
+                batch = 0;
+            }
+            if (set) set_destroy(set);
+            set = build_leader(len, offset, largest);
+            since_build = 0;
+        }
+        ++since_build;
+        int w = next_key() % KERNEL_WORKERS;
+        node__t * last = largest[w].largest_ptr;
+        if (last == NULL || last->key <= 1) continue;
+        int k = 1 + next_key() % (last->key - 1);
+        k_t key_rem;
+        if (count_misses) {
+            if (batch == 0) counters->start();
+            harris_insert_and_move(set, &largest[w], w, 0, &key_rem, k, k);
+            if (++batch == KERNEL_MISS_BATCH) {
+                counters->stop(move.misses);
+                batch = 0;
+            }
+        } else {
+            uint64_t t0 = get_server_clock();
+            harris_insert_and_move(set, &largest[w], w, 0, &key_rem, k, k);
+            uint64_t t1 = get_server_clock();
+            move.ns += t1 - t0;
+        }
+        ++done;
+    }
+    if (batch > 0) counters->stop(move.misses);
+    set_destroy(set);
+}
+
+static void bench_move(long long max_len, long long ops, int offset) {
+    print_header("move", "length");
+    for (long long len = KERNEL_WORKERS; len <= max_len; len *= 2) {
+        kernel_result move = {ops, 0, {0, 0}};
+        run_moves(len, ops, offset, false, move);
+        run_moves(len, ops, offset, true, move);
+        print_result("move", len, "insert_move", move);
+    }
+}
+
+int main(int argc, char** argv) {
+    int hls = 1024;
+    long long max_heap = 1 << 20;
+    long long max_leader = 4096;
+    long long ops = 100000;
+    int offset = 32;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            hls = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-heap") == 0 && i + 1 < argc) {
+            max_heap = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-leader") == 0 && i + 1 < argc) {
+            max_leader = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            ops = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            offset = atoi(argv[++i]);
+        } else {
+            printf("usage: %s [-h heap list size] [-heap max heap size] [-leader max leader length] [-o ops per size] [-m max offset]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (hls < 1 || max_heap < 1 || max_leader < 1 || ops < 1) {
+        printf("sizes and op counts must be positive\n");
+        return 2;
+    }
+
+    counters = new cache_counters();
+    calibrate_timer();
+    printf("heap list size                : %d\n", hls);
+    printf("ops per size                  : %lld\n", ops);
+    printf("timer cost (subtracted)       : %.1f ns\n", timer_ns);
+    if (!counters->available(0) && !counters->available(1)) {
+        printf("cache misses                  : n/a (perf_event_open not permitted, see perf_event_paranoid)\n");
+    }
+
+    pq<long long> * q = new pq<long long>(hls, 0, 0, 1, 3, 10, offset);
+    bench_worker(q, max_heap, ops, hls);
+    bench_leader(max_leader, ops, offset);
+    bench_move(max_leader, ops, offset);
+    delete counters;
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * File:   key_distribution.h
+ *
+ * Key generators for the microbenchmark workloads, selected with -dist (and tuned with -dparam).
+ * Every workload draws its keys through next_key(tid, rng), so a distribution applies to all of them.
+ */
+
+#ifndef KEY_DISTRIBUTION_H
+#define	KEY_DISTRIBUTION_H
+
+#include <cmath>
+#include <cstring>
+#include "../common/random.h"
+
+#define KEY_DIST_UNIFORM 0
+#define KEY_DIST_ZIPF 1 // -dparam: exponent (default 0.99); key k has weight 1/k^s, so small (high priority) keys are hot
+#define KEY_DIST_ASCENDING 2 // -dparam: noise width (default 1000); each thread counts up through the key range
+#define KEY_DIST_DESCENDING 3 // -dparam: noise width (default 1000); each thread counts down through the key range
+#define KEY_DIST_DISJOINT 4 // thread tid only uses keys in the tid-th of THREADS equal slices of the key range
+#define KEY_DIST_CLUSTERED 5 // -dparam: number of clusters (default 16), each spanning 1% of its share of the key range
+#define KEY_DIST_DUPLICATES 6 // -dparam: number of distinct keys (default 100)
+#define NUM_KEY_DISTS 7
+
+const char * KEY_DIST_NAMES[] = {"uniform", "zipf", "ascending", "descending", "disjoint", "clustered", "duplicates"};
+const double KEY_DIST_DEFAULT_PARAM[] = {0, 0.99, 1000, 1000, 0, 16, 100};
+
+long long key_dist_pos[MAX_TID_POW2*PREFETCH_SIZE_WORDS]; // per-thread position for the ramps
+
+// zipf sampling by rejection-inversion (Hormann and Derflinger), O(1) per key without a table over the key range
+double zipf_s;
+double zipf_h_integral_x1;
+double zipf_h_integral_n;
+double zipf_threshold;
+
+inline double zipf_helper1(double x) { // log1p(x)/x
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1. / 3 - 0.25 * x));
+}
+
+inline double zipf_helper2(double x) { // expm1(x)/x
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1. / 3) * (1 + 0.25 * x));
+}
+
+inline double zipf_h(double x) {
+    return exp(-zipf_s * log(x));
+}
+
+inline double zipf_h_integral(double x) {
+    double log_x = log(x);
+    return zipf_helper2((1 - zipf_s) * log_x) * log_x;
+}
+
+inline double zipf_h_integral_inverse(double x) {
+    double t = x * (1 - zipf_s);
+    if (t < -1) t = -1;
+    return exp(zipf_helper1(t) * x);
+}
+
+inline int zipf_next(Random *rng) {
+    while (true) {
+        double u = zipf_h_integral_n + (rng->nextNatural() / 4294967296.) * (zipf_h_integral_x1 - zipf_h_integral_n);
+        double x = zipf_h_integral_inverse(u);
+        int k = (int) (x + 0.5);
+        if (k < 1) k = 1;
+        else if (k > MAXKEY) k = MAXKEY;
+        if (k - x <= zipf_threshold || u >= zipf_h_integral(k + 0.5) - zipf_h(k)) {
+            return k;
+        }
+    }
+}
+
+// call once, after the command line is parsed
+void key_distribution_init() {
+    if (KEY_DIST_PARAM < 0) {
+        KEY_DIST_PARAM = KEY_DIST_DEFAULT_PARAM[KEY_DIST];
+    }
+    memset(key_dist_pos, 0, sizeof(key_dist_pos));
+    if (KEY_DIST == KEY_DIST_ZIPF) {
+        zipf_s = KEY_DIST_PARAM;
+        zipf_h_integral_x1 = zipf_h_integral(1.5) - 1;
+        zipf_h_integral_n = zipf_h_integral(MAXKEY + 0.5);
+        zipf_threshold = 2 - zipf_h_integral_inverse(zipf_h_integral(2.5) - zipf_h(2));
+    }
+}
+
+// a key in [1, MAXKEY]
+inline int next_key(int tid, Random *rng) {
+    switch (KEY_DIST) {
+        case KEY_DIST_UNIFORM:
+            return rng->nextNatural(MAXKEY) + 1;
+        case KEY_DIST_ZIPF:
+            return zipf_next(rng);
+        case KEY_DIST_ASCENDING:
+        case KEY_DIST_DESCENDING: {
+            // threads interleave along the ramp, so together they sweep it once per MAXKEY keys
+            long long pos = (key_dist_pos[tid*PREFETCH_SIZE_WORDS]++) * THREADS + tid;
+            if ((int) KEY_DIST_PARAM > 0) pos += rng->nextNatural((int) KEY_DIST_PARAM);
+            int key = (int) (pos % MAXKEY);
+            return (KEY_DIST == KEY_DIST_ASCENDING ? key + 1 : MAXKEY - key);
+        }
+        case KEY_DIST_DISJOINT: {
+            int range = max(1, MAXKEY / THREADS);
+            return tid * range + rng->nextNatural(range) + 1;
+        }
+        case KEY_DIST_CLUSTERED: {
+            int clusters = max(1, (int) KEY_DIST_PARAM);
+            int share = max(1, MAXKEY / clusters);
+            int width = max(1, share / 100);
+            int c = rng->nextNatural(clusters);
+            return c * share + (share - width) / 2 + rng->nextNatural(width) + 1;
+        }
+        case KEY_DIST_DUPLICATES: {
+            int distinct = max(1, (int) KEY_DIST_PARAM);
+            return rng->nextNatural(distinct) * max(1, MAXKEY / distinct) + 1;
+        }
+    }
+    return rng->nextNatural(MAXKEY) + 1;
+}
+
+#endif	/* KEY_DISTRIBUTION_H */
@@ -15,15 +15,21 @@ typedef long long test_type;
 #include <cassert>
 #include <unistd.h>   
 #include <set>
+#include <cmath>
 #include "globals.h"
 #include "globals_extern.h"
 #include "../common/random.h"
 #include "../common/binding.h"
 #include "../common/papi_util_impl.h"
+#include "../common/json_results.h"
+#include "../common/pq_trace.h"
+#include "../common/rank_error.h"
+#include "../common/pq_lincheck.h"
 #ifdef USE_DEBUGCOUNTERS
     #include "debugcounters.h"
 #endif
 #include "data_structures.h"
+#include "key_distribution.h"
 
 #ifdef ARRAY_SKIPLIST
 OPTSTM2_GLOBALS_INITIALIZER;
@@ -104,6 +110,42 @@ long size_chunkedpq = 0;
 #endif
 
 pthread_barrier_t WaitForThreads;
+unsigned long long start_clock; // get_server_clock() when the trial started
+
+// open-loop benchmark (BENCHMARK = 14): per-thread latency histograms, each power of two split into linear sub-buckets
+#define OPEN_LOOP_SUB_BUCKETS_LOG 4
+#define OPEN_LOOP_SUB_BUCKETS (1 << OPEN_LOOP_SUB_BUCKETS_LOG)
+#define OPEN_LOOP_BUCKETS (64 * OPEN_LOOP_SUB_BUCKETS)
+#define OPEN_LOOP_ARRIVAL_FIXED 0
+#define OPEN_LOOP_ARRIVAL_POISSON 1
+
+long long open_loop_hist[MAX_TID_POW2][OPEN_LOOP_BUCKETS];
+long long open_loop_late[MAX_TID_POW2*PREFETCH_SIZE_WORDS]; // ops that started more than one inter-arrival gap behind schedule
+
+inline int open_loop_bucket(unsigned long long latency) {
+    if (latency < OPEN_LOOP_SUB_BUCKETS) return latency;
+    int lg = 63 - __builtin_clzll(latency);
+    int sub = (latency >> (lg - OPEN_LOOP_SUB_BUCKETS_LOG)) & (OPEN_LOOP_SUB_BUCKETS - 1);
+    return (lg - OPEN_LOOP_SUB_BUCKETS_LOG + 1) * OPEN_LOOP_SUB_BUCKETS + sub;
+}
+
+// upper bound of a bucket's latency range
+inline unsigned long long open_loop_bucket_latency(int bucket) {
+    if (bucket < OPEN_LOOP_SUB_BUCKETS) return bucket;
+    int lg = bucket / OPEN_LOOP_SUB_BUCKETS + OPEN_LOOP_SUB_BUCKETS_LOG - 1;
+    int sub = bucket % OPEN_LOOP_SUB_BUCKETS;
+    return ((unsigned long long)(OPEN_LOOP_SUB_BUCKETS + sub + 1) << (lg - OPEN_LOOP_SUB_BUCKETS_LOG)) - 1;
+}
+
+// time until this thread's next arrival; THREADS threads together offer OPEN_LOOP_RATE ops/sec
+inline double open_loop_gap(Random *rng) {
+    double mean = 1e9 * THREADS / OPEN_LOOP_RATE;
+    if (OPEN_LOOP_ARRIVAL == OPEN_LOOP_ARRIVAL_POISSON) {
+        double u = rng->nextNatural() / 4294967296.;
+        return -log(1. - u) * mean;
+    }
+    return mean;
+}
 
 struct thread_arg {
     pthread_t* thread;
@@ -111,6 +153,102 @@ struct thread_arg {
     int tid;
 };
 
+// hold model (BENCHMARK = 15) and PHOLD (BENCHMARK = 16): every delete-min is followed by an insert of an event one
+// increment (drawn from HOLD_DIST with mean HOLD_MEAN) past the popped one; in PHOLD it goes to a random LP
+#define HOLD_DIST_EXPONENTIAL 0
+#define HOLD_DIST_UNIFORM 1
+#define HOLD_DIST_BIMODAL 2
+#define HOLD_DIST_TRIANGULAR 3
+const char * HOLD_DIST_NAMES[] = {"exponential", "uniform", "bimodal", "triangular"};
+
+std::atomic<long long> * des_lvt; // per-LP local virtual time (timestamp of the latest event it executed)
+long long des_violations[MAX_TID_POW2*PREFETCH_SIZE_WORDS]; // events executed below their LP's local virtual time
+
+// an event's key is (t - hold_base) * hold_lps() + lp for simulated time t (64-bit) and destination LP lp, so the
+// keys stay in int range however far the simulation runs: once a key passes HOLD_REBASE_KEY every thread stops at a
+// rendezvous and the last one to arrive moves the whole queue down to its minimum (hold_rebase)
+#define HOLD_REBASE_KEY (1 << 30)
+long long hold_base; // simulated time of key 0; only changed by hold_rebase, while every other thread waits
+volatile bool hold_rebase_pending;
+std::atomic<int> hold_rebase_arrived;
+volatile int hold_rebase_gen; // bumped when a rebase is done, releasing the waiting threads
+long long hold_rebases;
+
+// per-interval timeline (-timeline <ms>, benchmarks 3 and 5): each thread counts its ops and their latency per
+// interval in its own array, so nothing is shared while recording; the arrays are merged into a time series at the end
+#define TIMELINE_MAX_MILLIS 600000 // ops past this are counted in the last interval (-b 5 runs have no fixed length)
+#define TIMELINE_STEADY_WINDOW 10 // intervals the steady-state detector looks at together
+#define TIMELINE_STEADY_CV 0.05 // a window is steady when the stdev of its throughput is below this fraction of the mean
+
+struct timeline_interval {
+    long long inserts;
+    long long delmins;
+    long long latency; // sum over the interval's ops, in get_server_clock() units
+};
+
+timeline_interval * timeline[MAX_TID_POW2];
+int timeline_intervals;
+
+// called by each thread before prefilling, so the thread's array is first touched on its own NUMA zone
+void timeline_thread_init(int tid) {
+    timeline[tid] = new timeline_interval[timeline_intervals]();
+}
+
+inline void timeline_record(int tid, unsigned long long op_start, bool insert) {
+    unsigned long long now = get_server_clock();
+    long long ix = (now > start_clock ? now - start_clock : 0) / (TIMELINE_INTERVAL_MS * 1000000ULL);
+    timeline_interval * interval = &timeline[tid][min(ix, (long long) timeline_intervals - 1)];
+    if (insert) {
+        ++interval->inserts;
+    } else {
+        ++interval->delmins;
+    }
+    interval->latency += now - op_start;
+}
+
+// trace recording (-record, benchmark 3) and replay (BENCHMARK = 17, -replay); replayed keys are shifted up by one
+// so traces from sssp, whose source has key 0, stay in the microbenchmark's [1, MAXKEY] key range
+pq_trace_recorder * trace_recorder = NULL;
+rank_error_stats rank_stats;
+pq_lincheck_result lincheck_result;
+pq_trace_reader trace_replay;
+long long trace_replay_late[MAX_TID_POW2*PREFETCH_SIZE_WORDS]; // with -replay_timing: ops issued over 1 ms after their recorded time
+
+inline int hold_increment(Random *rng) {
+    double u = rng->nextNatural() / 4294967296.;
+    switch (HOLD_DIST) {
+        case HOLD_DIST_EXPONENTIAL:
+            return (int) (-log(1. - u) * HOLD_MEAN);
+        case HOLD_DIST_UNIFORM: // [0, 2*mean]
+            return (int) (u * 2 * HOLD_MEAN);
+        case HOLD_DIST_BIMODAL: { // 90% in [0, 0.2*mean], 10% in [8.1*mean, 10.1*mean]
+            double v = rng->nextNatural() / 4294967296.;
+            return (int) (u < 0.9 ? v * 0.2 * HOLD_MEAN : (8.1 + v * 2) * HOLD_MEAN);
+        }
+        case HOLD_DIST_TRIANGULAR: { // sum of two uniforms on [0, mean]
+            double v = rng->nextNatural() / 4294967296.;
+            return (int) ((u + v) * HOLD_MEAN);
+        }
+    }
+    return HOLD_MEAN;
+}
+
+inline int hold_lps() {
+    return BENCHMARK == 16 ? DES_LPS : 1; // the hold model is PHOLD with one LP
+}
+
+inline int hold_key(long long time, int lp) {
+    long long key = (time - hold_base) * hold_lps() + lp;
+    if (key > HOLD_REBASE_KEY && !hold_rebase_pending) {
+        hold_rebase_pending = true;
+    }
+    return (int) key;
+}
+
+inline long long hold_time(int key) {
+    return hold_base + key / hold_lps();
+}
+
 void print_atomic(string coutstr) {
     stringstream ss;
     ss<<coutstr;
@@ -136,7 +274,7 @@ void thread_prefill(int tid, int desg=0, void* t_inf_void=nullptr) {
     }
    
     while (cnt > 0) {
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
         //COUTATOMIC("Inserting " << key << "\n");
         GSTATS_TIMER_RESET(tid, timer_latency);
@@ -152,6 +290,7 @@ void thread_prefill(int tid, int desg=0, void* t_inf_void=nullptr) {
         
             GSTATS_ADD(tid, key_checksum, key);
             GSTATS_ADD(tid, prefill_size, 1);
+            if (trace_recorder) trace_recorder->record_prefill(tid, key, value);
             cnt--;
   #ifdef USE_DEBUGCOUNTERS
             glob.keysum->add(tid, key);
@@ -170,6 +309,23 @@ void thread_prefill(int tid, int desg=0, void* t_inf_void=nullptr) {
     glob.__garbage += garbage;
 }
 
+// the hold model's initial queue: PREFILL_AMT events, each one increment past time 0 (at a random LP for PHOLD)
+void thread_prefill_hold(int tid) {
+    Random *rng = &glob.rngs[tid*PREFETCH_SIZE_WORDS];
+    DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
+
+    int cnt = (PREFILL_AMT / (THREADS));
+    while (cnt > 0) {
+        int key = hold_key(hold_increment(rng) + 1, rng->nextNatural() % hold_lps());
+        long long value = key;
+        if (INSERT_AND_CHECK_SUCCESS) {
+            GSTATS_ADD(tid, key_checksum, key);
+            GSTATS_ADD(tid, prefill_size, 1);
+            cnt--;
+        }
+    }
+}
+
 void *phased_num_ops(void *arg) {
     int tid = *((int*) arg);
     binding_bindThread(tid, LOGICAL_PROCESSORS);
@@ -186,6 +342,9 @@ void *phased_num_ops(void *arg) {
     unsigned int seed = glob.seeds_[tid];
     #endif
     INIT_THREAD(tid);
+    if (TIMELINE_INTERVAL_MS > 0) {
+        timeline_thread_init(tid);
+    }
 
     pthread_barrier_wait(&WaitForAll);
     thread_prefill(tid);
@@ -220,11 +379,12 @@ void *phased_num_ops(void *arg) {
         while (num_ops > 0) {
             //if (((num_ops % 100000) == 0)) COUTATOMICTID("op# "<<num_ops<<endl);
             
-            int key = rng->nextNatural(MAXKEY) + 1;
+            int key = next_key(tid, rng);
             long long value = rng->nextNatural(MAXKEY) + 1;;
             double op = rng->nextNatural(100000000) / 1000000.;
             if (op < percent_insertions) {
                 GSTATS_TIMER_RESET(tid, timer_latency);
+                unsigned long long op_start = (TIMELINE_INTERVAL_MS > 0 ? get_server_clock() : 0);
                 if (INSERT_AND_CHECK_SUCCESS) {
                     GSTATS_ADD(tid, key_checksum, key);
         #ifdef USE_DEBUGCOUNTERS
@@ -234,10 +394,12 @@ void *phased_num_ops(void *arg) {
                     GET_COUNTERS->insertFail->inc(tid);
         #endif
                 }
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
+                if (TIMELINE_INTERVAL_MS > 0) timeline_record(tid, op_start, true);
                 GSTATS_ADD(tid, num_inserts, 1);
             } else {
                 GSTATS_TIMER_RESET(tid, timer_latency);
+                unsigned long long op_start = (TIMELINE_INTERVAL_MS > 0 ? get_server_clock() : 0);
             #ifdef LINDEN
                 int min_key, min_val;
             #elif defined(SMQ)
@@ -246,7 +408,8 @@ void *phased_num_ops(void *arg) {
                 long unsigned min_key, min_val;
             #endif
                 DELETE_AND_CHECK_SUCCESS;
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
+                if (TIMELINE_INTERVAL_MS > 0) timeline_record(tid, op_start, false);
                 if (min_key > 0) {
                     GSTATS_ADD(tid, key_checksum, -min_key);
                 }
@@ -380,7 +543,7 @@ void *mixed_num_ops(void *arg) {
             me->op_begin();
           #endif
             if (op < INS) {
-                int key = rng->nextNatural(MAXKEY) + 1;
+                int key = next_key(tid, rng);
                 long long value = rng->nextNatural(MAXKEY) + 1;
                 GSTATS_TIMER_RESET(tid, timer_latency);
               #ifdef CBPQ
@@ -393,7 +556,7 @@ void *mixed_num_ops(void *arg) {
                     GSTATS_ADD(tid, key_checksum, key);
                     //ops_success--;
                 }
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
                 GSTATS_ADD(tid, num_inserts, 1);
             } else {
                 GSTATS_TIMER_RESET(tid, timer_latency);
@@ -410,7 +573,7 @@ void *mixed_num_ops(void *arg) {
                 DELETE_AND_CHECK_SUCCESS;
                 #endif
                 //ops_success--;
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
                 if (min_key > 0) {
                     GSTATS_ADD(tid, key_checksum, -min_key);
                 }
@@ -552,7 +715,7 @@ void *desg_threads_delmin_numa(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
         //double op = rng->nextNatural(100000000) / 1000000.;
         if (tid < DELMIN_THREADS_PER_ZONE) {
@@ -566,7 +729,7 @@ void *desg_threads_delmin_numa(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -584,7 +747,7 @@ void *desg_threads_delmin_numa(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
     #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         }
         GSTATS_ADD(tid, num_operations, 1);
@@ -682,7 +845,7 @@ void *mixed_workload_timed_desg_threads(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
         //double op = rng->nextNatural(100000000) / 1000000.;
         if (thread_idx < del_min_per_zone) {
@@ -696,7 +859,7 @@ void *mixed_workload_timed_desg_threads(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -714,7 +877,7 @@ void *mixed_workload_timed_desg_threads(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
     #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         }
         GSTATS_ADD(tid, num_operations, 1);
@@ -821,7 +984,7 @@ void *mixed_workload_timed_desg_threads_lol(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
 
         if (tid >= tot_delmin_desg) {
@@ -836,7 +999,7 @@ void *mixed_workload_timed_desg_threads_lol(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
             #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         } else {
             //COUTATOMIC("tid-" << tid << ": performing delmin\n");
@@ -850,7 +1013,7 @@ void *mixed_workload_timed_desg_threads_lol(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -988,7 +1151,7 @@ void *mixed_workload_timed_desg_threads_one_numa(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
 
         if (idx >= del_min_per_numa) {
@@ -1003,7 +1166,7 @@ void *mixed_workload_timed_desg_threads_one_numa(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
             #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         } else {
             //COUTATOMIC("tid-" << tid << ": performing delmin\n");
@@ -1017,7 +1180,7 @@ void *mixed_workload_timed_desg_threads_one_numa(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1087,7 +1250,7 @@ void *alternate_workload_timed(void *arg) {
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
         
         if (op == 1) { // INSERT
-            int key = rng->nextNatural(MAXKEY) + 1;
+            int key = next_key(tid, rng);
             long long value = rng->nextNatural(MAXKEY) + 1;
             GSTATS_TIMER_RESET(tid, timer_latency);
             if (INSERT_AND_CHECK_SUCCESS) {
@@ -1099,7 +1262,7 @@ void *alternate_workload_timed(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
     #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         } else { // DELETE
             
@@ -1113,7 +1276,7 @@ void *alternate_workload_timed(void *arg) {
             GSTATS_TIMER_RESET(tid, timer_latency);
             DELETE_AND_CHECK_SUCCESS;
             //GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1169,6 +1332,9 @@ void *mixed_workload_timed(void *arg) {
     #endif
 
     INIT_THREAD(tid);
+    if (TIMELINE_INTERVAL_MS > 0) {
+        timeline_thread_init(tid);
+    }
     pthread_barrier_wait(&WaitForAll);
     if (tid == 0) {
         COUTATOMIC("Prefilling...\n");
@@ -1225,7 +1391,7 @@ void *mixed_workload_timed(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
         double op = rng->nextNatural(100000000) / 1000000.;
        #ifdef ARRAY_SKIPLIST
@@ -1242,11 +1408,15 @@ void *mixed_workload_timed(void *arg) {
         } else {
             if (op < INS) {
                 GSTATS_TIMER_RESET(tid, timer_latency);
+                unsigned long long op_start = (TIMELINE_INTERVAL_MS > 0 ? get_server_clock() : 0);
+                uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
+                bool inserted = false;
             #ifdef CBPQ
                 if (INSERT_AND_CHECK_SUCCESS_CBPQ) {
             #else
                 if (INSERT_AND_CHECK_SUCCESS) {
             #endif
+                    inserted = true;
                     GSTATS_ADD(tid, key_checksum, key);
         #ifdef USE_DEBUGCOUNTERS
                     glob.keysum->add(tid, key);
@@ -1255,16 +1425,21 @@ void *mixed_workload_timed(void *arg) {
                     GET_COUNTERS->insertFail->inc(tid);
         #endif
                 }
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
+                if (TIMELINE_INTERVAL_MS > 0) timeline_record(tid, op_start, true);
+                if (trace_recorder && inserted) trace_recorder->record(tid, PQ_TRACE_INSERT, key, value, invoke); // a rejected duplicate did not change the pq
                 GSTATS_ADD(tid, num_inserts, 1);
             } else {
                 GSTATS_TIMER_RESET(tid, timer_latency);
+                unsigned long long op_start = (TIMELINE_INTERVAL_MS > 0 ? get_server_clock() : 0);
+                uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
+            // min_val is traced even when an empty delete-min leaves it unset
             #ifdef LINDEN
-                int min_key, min_val;
+                int min_key, min_val = 0;
             #elif defined(SMQ) || defined(ARRAY_SKIPLIST)
-                long min_key, min_val;
+                long min_key, min_val = 0;
             #else
-                long unsigned min_key, min_val;
+                long unsigned min_key, min_val = 0;
             #endif
             #ifdef CBPQ 
                 DELETE_AND_CHECK_SUCCESS_CBPQ;
@@ -1272,7 +1447,9 @@ void *mixed_workload_timed(void *arg) {
                 DELETE_AND_CHECK_SUCCESS;
             #endif
                 //GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
-                GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+                GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
+                if (TIMELINE_INTERVAL_MS > 0) timeline_record(tid, op_start, false);
+                if (trace_recorder) trace_recorder->record(tid, PQ_TRACE_DELETE_MIN, (min_key > 0 ? (int64_t) min_key : PQ_TRACE_EMPTY), min_val, invoke);
                 //COUTATOMIC("Returned: " << min_key << "\n");
 
                 if (min_key > 0) {
@@ -1353,7 +1530,7 @@ void *mixed_workload_every_other_timed(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
         if (cnt % 2 == 0) { // INS
             GSTATS_TIMER_RESET(tid, timer_latency);
@@ -1366,7 +1543,7 @@ void *mixed_workload_every_other_timed(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
     #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         } else { // DEL
             GSTATS_TIMER_RESET(tid, timer_latency);
@@ -1378,7 +1555,373 @@ void *mixed_workload_every_other_timed(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
+            if (min_key > 0) {
+                GSTATS_ADD(tid, key_checksum, -min_key);
+            }
+            GSTATS_ADD(tid, num_delmin, 1);
+        }
+        GSTATS_ADD(tid, num_operations, 1);
+    }
+    
+    glob.running.fetch_add(-1);
+    while (glob.running.load()) { /* wait */ }
+    
+    papi_stop_counters(tid);
+    glob.__garbage += garbage;
+    pthread_exit(NULL);
+}
+
+void *open_loop_timed(void *arg) {
+    int tid = *((int*) arg);
+    binding_bindThread(tid, LOGICAL_PROCESSORS);
+    
+    test_type garbage = 0;
+    Random *rng = &glob.rngs[tid*PREFETCH_SIZE_WORDS];
+    DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
+
+    #ifdef SPRAY
+    unsigned int seed = glob.seeds_[tid];
+    #endif
+    INIT_THREAD(tid);
+    pthread_barrier_wait(&WaitForAll);
+    if (tid == 0) {
+        COUTATOMIC("Prefilling...\n");
+    }
+    thread_prefill(tid);
+    pthread_barrier_wait(&WaitForAll);
+
+  #if defined(PIPQ_STRICT) || defined(PIPQ_RELAXED) || defined(LLSL_TEST) || defined(PIPQ_STRICT_ATOMIC)
+    if (tid == 0) {
+        long long curr_keysum = ds->getKeySum();
+        COUTATOMIC("After prefilling, sum: " << curr_keysum << "\n");
+        COUTATOMIC("Size: " << ds->getSize() << "\n");
+    }
+    pthread_barrier_wait(&WaitForAll);
+  #endif
+    long long *hist = open_loop_hist[tid];
+    memset(hist, 0, sizeof(open_loop_hist[tid]));
+    open_loop_late[tid*PREFETCH_SIZE_WORDS] = 0;
+    const double mean_gap = 1e9 * THREADS / OPEN_LOOP_RATE;
+
+    papi_create_eventset(tid);
+    glob.running.fetch_add(1);
+    __sync_synchronize();
+    while (!glob.start) { __sync_synchronize(); TRACE COUTATOMICTID("waiting to start"<<endl); } // wait to start
+    papi_start_counters(tid);
+
+    // the schedule is fixed up front, so an op that is held up delays the ops behind it,
+    // and that queueing delay is charged to their latency (no coordinated omission)
+    double intended = get_server_clock();
+    if (OPEN_LOOP_ARRIVAL == OPEN_LOOP_ARRIVAL_FIXED) {
+        intended += mean_gap * tid / THREADS; // stagger the threads' ticks
+    } else {
+        intended += open_loop_gap(rng);
+    }
+    int cnt = 0;
+    while (!glob.done) {
+        if (((++cnt) % OPS_BETWEEN_TIME_CHECKS) == 0) {
+            chrono::time_point<chrono::high_resolution_clock> __endTime = chrono::high_resolution_clock::now();
+            if (chrono::duration_cast<chrono::milliseconds>(__endTime-glob.startTime).count() >= abs(MILLIS_TO_RUN)) {
+                __sync_synchronize();
+                glob.done = true;
+                __sync_synchronize();
+                break;
+            }
+        }
+
+        // wait for the op's arrival time (sleep if it is far away)
+        unsigned long long start = (unsigned long long) intended;
+        unsigned long long now = get_server_clock();
+        while (now < start && !glob.done) {
+            if (start - now > 200000) {
+                timespec nap;
+                nap.tv_sec = 0;
+                nap.tv_nsec = start - now - 100000;
+                nanosleep(&nap, NULL);
+            }
+            now = get_server_clock();
+        }
+        if (glob.done) break;
+        if (now - start > mean_gap) {
+            ++open_loop_late[tid*PREFETCH_SIZE_WORDS];
+        }
+
+        VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
+        int key = next_key(tid, rng);
+        long long value = rng->nextNatural(MAXKEY) + 1;
+        double op = rng->nextNatural(100000000) / 1000000.;
+        if (op < INS) {
+            if (INSERT_AND_CHECK_SUCCESS) {
+                GSTATS_ADD(tid, key_checksum, key);
+    #ifdef USE_DEBUGCOUNTERS
+                glob.keysum->add(tid, key);
+                GET_COUNTERS->insertSuccess->inc(tid);
+            } else {
+                GET_COUNTERS->insertFail->inc(tid);
+    #endif
+            }
+            unsigned long long latency = get_server_clock() - start;
+            GSTATS_SAMPLE(tid, latency_updates, latency);
+            ++hist[open_loop_bucket(latency)];
+            GSTATS_ADD(tid, num_inserts, 1);
+        } else {
+        #ifdef LINDEN
+            int min_key;
+        #elif defined(SMQ)
+            long min_key;
+        #else
+            long unsigned min_key;
+            [[maybe_unused]] long unsigned min_val; // written by the LOTAN, SPRAY and MOUNDS delete-mins
+        #endif
+            DELETE_AND_CHECK_SUCCESS;
+            unsigned long long latency = get_server_clock() - start;
+            GSTATS_SAMPLE(tid, latency_del, latency);
+            ++hist[open_loop_bucket(latency)];
+            if (min_key > 0) {
+                GSTATS_ADD(tid, key_checksum, -min_key);
+            }
+            GSTATS_ADD(tid, num_delmin, 1);
+        }
+        GSTATS_ADD(tid, num_operations, 1);
+        intended += open_loop_gap(rng);
+    }
+    
+    glob.running.fetch_add(-1);
+    while (glob.running.load()) { /* wait */ }
+    
+    papi_stop_counters(tid);
+    glob.__garbage += garbage;
+    pthread_exit(NULL);
+}
+
+void *hold_model_timed(void *arg) {
+    int tid = *((int*) arg);
+    binding_bindThread(tid, LOGICAL_PROCESSORS);
+    
+    test_type garbage = 0;
+    Random *rng = &glob.rngs[tid*PREFETCH_SIZE_WORDS];
+    DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
+
+    #ifdef SPRAY
+    unsigned int seed = glob.seeds_[tid];
+    #endif
+    INIT_THREAD(tid);
+    pthread_barrier_wait(&WaitForAll);
+    if (tid == 0) {
+        COUTATOMIC("Prefilling...\n");
+    }
+    thread_prefill_hold(tid);
+    pthread_barrier_wait(&WaitForAll);
+
+  #if defined(PIPQ_STRICT) || defined(PIPQ_RELAXED) || defined(LLSL_TEST) || defined(PIPQ_STRICT_ATOMIC)
+    if (tid == 0) {
+        long long curr_keysum = ds->getKeySum();
+        COUTATOMIC("After prefilling, sum: " << curr_keysum << "\n");
+        COUTATOMIC("Size: " << ds->getSize() << "\n");
+    }
+    pthread_barrier_wait(&WaitForAll);
+  #endif
+    if (BENCHMARK == 16) {
+        des_violations[tid*PREFETCH_SIZE_WORDS] = 0;
+    }
+
+    papi_create_eventset(tid);
+    glob.running.fetch_add(1);
+    __sync_synchronize();
+    while (!glob.start) { __sync_synchronize(); TRACE COUTATOMICTID("waiting to start"<<endl); } // wait to start
+    papi_start_counters(tid);
+    int cnt = 0;
+    while (!glob.done) {
+        if (((++cnt) % OPS_BETWEEN_TIME_CHECKS) == 0) {
+            chrono::time_point<chrono::high_resolution_clock> __endTime = chrono::high_resolution_clock::now();
+            if (chrono::duration_cast<chrono::milliseconds>(__endTime-glob.startTime).count() >= abs(MILLIS_TO_RUN)) {
+                __sync_synchronize();
+                glob.done = true;
+                __sync_synchronize();
+                break;
+            }
+        }
+    #ifdef LINDEN
+        int min_key;
+    #elif defined(SMQ)
+        long min_key;
+    #else
+        long unsigned min_key;
+        [[maybe_unused]] long unsigned min_val; // written by the LOTAN, SPRAY and MOUNDS delete-mins
+    #endif
+
+        if (hold_rebase_pending) {
+            int gen = hold_rebase_gen;
+            if (hold_rebase_arrived.fetch_add(1) + 1 == THREADS) {
+                // every other thread waits below, so the queue is ours: drain it and insert every key shifted down
+                std::vector<int> keys;
+                while (true) {
+                    DELETE_AND_CHECK_SUCCESS;
+                    if ((long long) min_key <= 0) break;
+                    keys.push_back((int) min_key);
+                    GSTATS_ADD(tid, key_checksum, -(long long) min_key);
+                }
+                long long shift = keys.empty() ? 0 : max<long long>(0, *std::min_element(keys.begin(), keys.end()) / hold_lps() - 1); // keeps keys > 0
+                hold_base += shift;
+                for (int old_key : keys) {
+                    int key = old_key - (int) (shift * hold_lps());
+                    long long value = key;
+                    if (INSERT_AND_CHECK_SUCCESS) {
+                        GSTATS_ADD(tid, key_checksum, key);
+                    }
+                }
+                ++hold_rebases;
+                hold_rebase_pending = false;
+                hold_rebase_arrived = 0;
+                __sync_synchronize();
+                hold_rebase_gen = gen + 1;
+            } else {
+                while (hold_rebase_gen == gen && !glob.done) { __sync_synchronize(); }
+            }
+            continue;
+        }
+        
+        VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
+        GSTATS_TIMER_RESET(tid, timer_latency);
+        DELETE_AND_CHECK_SUCCESS;
+        GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
+        GSTATS_ADD(tid, num_delmin, 1);
+        GSTATS_ADD(tid, num_operations, 1);
+
+        // the popped event runs at its destination LP, which schedules the next event for a random LP
+        long long now = hold_base;
+        int dest = rng->nextNatural() % hold_lps();
+        if ((long long) min_key > 0) {
+            GSTATS_ADD(tid, key_checksum, -(long long) min_key);
+            now = hold_time((int) min_key);
+            if (BENCHMARK == 16) {
+                // PHOLD: executing an event below its LP's clock is a causality violation
+                std::atomic<long long> * lvt = &des_lvt[(int) min_key % DES_LPS];
+                long long prev = lvt->load(std::memory_order_relaxed);
+                while (prev < now && !lvt->compare_exchange_weak(prev, now, std::memory_order_relaxed)) {}
+                if (prev > now) {
+                    ++des_violations[tid*PREFETCH_SIZE_WORDS];
+                }
+                for (int i = 0; i < DES_EVENT_WORK; i++) {
+                    garbage += rng->nextNatural();
+                }
+            }
+        } // else empty: start a new event at the base time
+
+        int key = hold_key(now + hold_increment(rng) + 1, dest);
+        long long value = key;
+        GSTATS_TIMER_RESET(tid, timer_latency);
+        if (INSERT_AND_CHECK_SUCCESS) {
+            GSTATS_ADD(tid, key_checksum, key);
+    #ifdef USE_DEBUGCOUNTERS
+            glob.keysum->add(tid, key);
+            GET_COUNTERS->insertSuccess->inc(tid);
+        } else {
+            GET_COUNTERS->insertFail->inc(tid);
+    #endif
+        }
+        GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
+        GSTATS_ADD(tid, num_inserts, 1);
+        GSTATS_ADD(tid, num_operations, 1);
+    }
+    
+    glob.running.fetch_add(-1);
+    while (glob.running.load()) { /* wait */ }
+    
+    papi_stop_counters(tid);
+    glob.__garbage += garbage;
+    pthread_exit(NULL);
+}
+
+void *trace_replay_thread(void *arg) {
+    int tid = *((int*) arg);
+    binding_bindThread(tid, LOGICAL_PROCESSORS);
+    
+    test_type garbage = 0;
+    DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
+    const pq_trace_record * records = trace_replay.thread_records(tid);
+    const long long num_records = trace_replay.count(tid);
+    trace_replay_late[tid*PREFETCH_SIZE_WORDS] = 0;
+
+    #ifdef SPRAY
+    unsigned int seed = glob.seeds_[tid];
+    #endif
+    INIT_THREAD(tid);
+    pthread_barrier_wait(&WaitForAll);
+    if (tid == 0) {
+        COUTATOMIC("Prefilling...\n");
+    }
+    thread_prefill(tid);
+    long long first = 0;
+    for (; first < num_records && records[first].op == PQ_TRACE_PREFILL; ++first) { // the trace's own prefill
+        int key = (int) records[first].key + 1;
+        long long value = records[first].value;
+        if (INSERT_AND_CHECK_SUCCESS) {
+            GSTATS_ADD(tid, key_checksum, key);
+            GSTATS_ADD(tid, prefill_size, 1);
+        }
+    }
+    pthread_barrier_wait(&WaitForAll);
+
+  #if defined(PIPQ_STRICT) || defined(PIPQ_RELAXED) || defined(LLSL_TEST) || defined(PIPQ_STRICT_ATOMIC)
+    if (tid == 0) {
+        long long curr_keysum = ds->getKeySum();
+        COUTATOMIC("After prefilling, sum: " << curr_keysum << "\n");
+        COUTATOMIC("Size: " << ds->getSize() << "\n");
+    }
+    pthread_barrier_wait(&WaitForAll);
+  #endif
+
+    papi_create_eventset(tid);
+    glob.running.fetch_add(1);
+    __sync_synchronize();
+    while (!glob.start) { __sync_synchronize(); TRACE COUTATOMICTID("waiting to start"<<endl); } // wait to start
+    papi_start_counters(tid);
+    for (long long i = first; i < num_records; ++i) {
+        const pq_trace_record * rec = &records[i];
+        if (TRACE_REPLAY_TIMING) {
+            unsigned long long due = start_clock + rec->time;
+            unsigned long long now = get_server_clock();
+            if (now > due + 1000000) {
+                ++trace_replay_late[tid*PREFETCH_SIZE_WORDS];
+            }
+            while (now < due) {
+                if (due - now > 100000) {
+                    timespec ts = {0, (long) (due - now - 50000)};
+                    nanosleep(&ts, NULL);
+                }
+                now = get_server_clock();
+            }
+        }
+
+        if (rec->op != PQ_TRACE_DELETE_MIN) {
+            int key = (int) rec->key + 1;
+            long long value = rec->value;
+            GSTATS_TIMER_RESET(tid, timer_latency);
+            if (INSERT_AND_CHECK_SUCCESS) {
+                GSTATS_ADD(tid, key_checksum, key);
+    #ifdef USE_DEBUGCOUNTERS
+                glob.keysum->add(tid, key);
+                GET_COUNTERS->insertSuccess->inc(tid);
+            } else {
+                GET_COUNTERS->insertFail->inc(tid);
+    #endif
+            }
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_ADD(tid, num_inserts, 1);
+        } else {
+            GSTATS_TIMER_RESET(tid, timer_latency);
+        #ifdef LINDEN
+            int min_key;
+        #elif defined(SMQ)
+            long min_key;
+        #else
+            long unsigned min_key;
+            [[maybe_unused]] long unsigned min_val; // written by the LOTAN, SPRAY and MOUNDS delete-mins
+        #endif
+            DELETE_AND_CHECK_SUCCESS;
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1431,7 +1974,7 @@ void *thread_timed_insert_only(void *arg) {
         }
         
         VERBOSE if (cnt&&((cnt % 1000000) == 0)) COUTATOMICTID("op# "<<cnt<<endl);
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
 
         GSTATS_TIMER_RESET(tid, timer_latency);
@@ -1444,7 +1987,7 @@ void *thread_timed_insert_only(void *arg) {
             GET_COUNTERS->insertFail->inc(tid);
     #endif
         }
-        GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+        GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
         GSTATS_ADD(tid, num_inserts, 1);
         GSTATS_ADD(tid, num_operations, 1);
         //sleep(1);
@@ -1487,7 +2030,7 @@ void *insert_only_num_ops(void *arg) {
     while (ops_success > 0) {
         VERBOSE if (ops_success&&((ops_success % 500) == 0)) COUTATOMICTID("op# "<<ops_success<<endl);
         
-        int key = rng->nextNatural(MAXKEY) + 1;
+        int key = next_key(tid, rng);
         long long value = rng->nextNatural(MAXKEY) + 1;
 
         GSTATS_TIMER_RESET(tid, timer_latency);
@@ -1507,7 +2050,7 @@ void *insert_only_num_ops(void *arg) {
             GET_COUNTERS->eraseSuccess->inc(tid);
     #endif
 
-        GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+        GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
         GSTATS_ADD(tid, num_inserts, 1);
         GSTATS_ADD(tid, num_operations, 1);
         //sleep(1);
@@ -1570,7 +2113,7 @@ void *thread_timed_delete_only(void *arg) {
         long unsigned min_key, min_val;
     #endif
         DELETE_AND_CHECK_SUCCESS;
-        GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+        GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
         ops_success--;
     #ifdef USE_DEBUGCOUNTERS
             glob.keysum->add(tid, -min_key);
@@ -1658,7 +2201,7 @@ void *thread_timed_insert_least_priority(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
         #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
 
         } else {
@@ -1672,7 +2215,7 @@ void *thread_timed_insert_least_priority(void *arg) {
         #endif
             DELETE_AND_CHECK_SUCCESS;
             //GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1768,7 +2311,7 @@ void *thread_timed_insert_alternating_priority(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
         #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
 
         } else {
@@ -1781,7 +2324,7 @@ void *thread_timed_insert_alternating_priority(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1868,7 +2411,7 @@ void *thread_timed_insert_highest_priority_only(void *arg) {
                 GET_COUNTERS->insertFail->inc(tid);
     #endif
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_updates);
             GSTATS_ADD(tid, num_inserts, 1);
         } else {
             GSTATS_TIMER_RESET(tid, timer_latency);
@@ -1880,7 +2423,7 @@ void *thread_timed_insert_highest_priority_only(void *arg) {
             long unsigned min_key, min_val;
         #endif
             DELETE_AND_CHECK_SUCCESS;
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_del);
+            GSTATS_TIMER_SAMPLE_ELAPSED(tid, timer_latency, latency_del);
             if (min_key > 0) {
                 GSTATS_ADD(tid, key_checksum, -min_key);
             }
@@ -1952,6 +2495,27 @@ void trial() {
     glob.__ds = (void *) DS_CONSTRUCTOR();
     #endif
     
+    if ((!TRACE_RECORD.empty() || RANK_ERROR || LINCHECK) && BENCHMARK == 3) {
+        trace_recorder = new pq_trace_recorder(THREADS, 1 << 18);
+    }
+    if (TIMELINE_INTERVAL_MS > 0) {
+        int millis = (BENCHMARK == 3 && MILLIS_TO_RUN > 0 ? min(MILLIS_TO_RUN, TIMELINE_MAX_MILLIS) : TIMELINE_MAX_MILLIS);
+        timeline_intervals = millis / TIMELINE_INTERVAL_MS + 2; // room for the partial interval at the end
+    }
+    if (BENCHMARK == 15 || BENCHMARK == 16) {
+        hold_base = 0;
+        hold_rebase_pending = false;
+        hold_rebase_arrived = 0;
+        hold_rebase_gen = 0;
+        hold_rebases = 0;
+    }
+    if (BENCHMARK == 16) {
+        des_lvt = new std::atomic<long long>[DES_LPS];
+        for (int i = 0; i < DES_LPS; ++i) {
+            des_lvt[i] = 0;
+        }
+    }
+
     glob.prefillIntervalElapsedMillis = 0;
     glob.prefillKeySum = 0;
     DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
@@ -2066,6 +2630,21 @@ void trial() {
                 cerr<<"ERROR: could not create thread"<<endl;
                 exit(-1);
             }
+        } else if (BENCHMARK == 14) {
+            if (pthread_create(threads[i], NULL, open_loop_timed, &ids[i])) {
+                cerr<<"ERROR: could not create thread"<<endl;
+                exit(-1);
+            }
+        } else if (BENCHMARK == 15 || BENCHMARK == 16) {
+            if (pthread_create(threads[i], NULL, hold_model_timed, &ids[i])) {
+                cerr<<"ERROR: could not create thread"<<endl;
+                exit(-1);
+            }
+        } else if (BENCHMARK == 17) {
+            if (pthread_create(threads[i], NULL, trace_replay_thread, &ids[i])) {
+                cerr<<"ERROR: could not create thread"<<endl;
+                exit(-1);
+            }
         }
     }
   #endif
@@ -2084,6 +2663,8 @@ void trial() {
     SOFTWARE_BARRIER;
 
     glob.startTime = chrono::high_resolution_clock::now(); // chrono::time_point<chrono::high_resolution_clock> __endTime = chrono::high_resolution_clock::now();
+    start_clock = get_server_clock();
+    if (trace_recorder) trace_recorder->start();
     __sync_synchronize();
     glob.start = true;
     SOFTWARE_BARRIER;
@@ -2094,7 +2675,7 @@ void trial() {
     //      if not, loop and sleep in small increments for up to 5s,
     //      and exit(-1) if running doesn't hit 0.
 
-    if (BENCHMARK == 0 || BENCHMARK == 3 || BENCHMARK == 6 || BENCHMARK == 7 || BENCHMARK == 9 || BENCHMARK == 10 || BENCHMARK == 11 || BENCHMARK == 12 ||  BENCHMARK == 61 ||  BENCHMARK == 13) {
+    if (BENCHMARK == 0 || BENCHMARK == 3 || BENCHMARK == 6 || BENCHMARK == 7 || BENCHMARK == 9 || BENCHMARK == 10 || BENCHMARK == 11 || BENCHMARK == 12 ||  BENCHMARK == 61 ||  BENCHMARK == 13 || BENCHMARK == 14 || BENCHMARK == 15 || BENCHMARK == 16) {
         if (MILLIS_TO_RUN > 0) {
             nanosleep(&tsExpected, NULL);
             SOFTWARE_BARRIER;
@@ -2133,13 +2714,31 @@ void trial() {
         }
     }
     __sync_synchronize();
+
+    if (trace_recorder) {
+        if (RANK_ERROR) {
+            rank_stats = rank_error_analyze(*trace_recorder);
+        }
+        if (LINCHECK) {
+            lincheck_result = pq_lincheck(*trace_recorder);
+        }
+        if (!TRACE_RECORD.empty()) { // otherwise only traced for -rank or -lincheck
+            if (trace_recorder->write(TRACE_RECORD.c_str())) {
+                COUTATOMIC("recorded "<<trace_recorder->size()<<" ops to "<<TRACE_RECORD<<endl);
+            } else {
+                COUTATOMIC("ERROR: could not write trace "<<TRACE_RECORD<<endl);
+            }
+        }
+        delete trace_recorder;
+        trace_recorder = NULL;
+    }
     
     COUTATOMIC(endl);
     COUTATOMIC("###############################################################################"<<endl);
     COUTATOMIC("################################# END RUNNING #################################"<<endl);
     COUTATOMIC("###############################################################################"<<endl);
     COUTATOMIC(endl);
-    if (BENCHMARK == 0 || BENCHMARK == 3 || BENCHMARK == 6 || BENCHMARK == 7 || BENCHMARK == 12 || BENCHMARK == 61 || BENCHMARK == 13) {
+    if (BENCHMARK == 0 || BENCHMARK == 3 || BENCHMARK == 6 || BENCHMARK == 7 || BENCHMARK == 12 || BENCHMARK == 61 || BENCHMARK == 13 || BENCHMARK == 14 || BENCHMARK == 15 || BENCHMARK == 16) {
         COUTATOMIC(((glob.elapsedMillis+glob.elapsedMillisNapping)/1000.)<<"s"<<endl);
     }
 
@@ -2189,10 +2788,52 @@ void parse_mixed_workload(std::string workload) {
     }
 }
 
+#ifdef USE_GSTATS
+// percentiles of the samples GSTATS kept for a latency stat (each thread keeps a uniform sample of its operations, up to the stat's capacity)
+json_record latency_percentiles(stat_id stat) {
+    vector<long long> samples;
+    for (int tid = 0; tid < THREADS; ++tid) {
+        for (int i = 0; i < GSTATS_GET_SIZE(tid, stat); ++i) {
+            samples.push_back(GSTATS_GET_IX(tid, stat, i));
+        }
+    }
+    json_record rec;
+    rec.add("samples", (long long) samples.size());
+    if (samples.empty()) {
+        return rec;
+    }
+    sort(samples.begin(), samples.end());
+    const double percentiles[] = {50, 90, 99, 99.9};
+    const char * names[] = {"p50", "p90", "p99", "p99.9"};
+    for (int p = 0; p < 4; ++p) {
+        size_t rank = max((size_t) 1, (size_t) ceil(percentiles[p] / 100. * samples.size()));
+        rec.add(names[p], samples[rank - 1]);
+    }
+    rec.add("max", samples.back());
+    return rec;
+}
+#endif
+
 void printOutput() {
     cout<<"PRODUCING OUTPUT"<<endl;
     DS_DECLARATION * ds = (DS_DECLARATION *) glob.__ds;
 
+    // machine-readable copy of the results, written to JSON_OUTPUT (-json) at the end
+    json_record config, results, validation, pipq_paths, papi;
+    config.add("ds", DS_NAME).add("benchmark", BENCHMARK).add("threads", THREADS).add("ins", INS).add("del", DEL)
+          .add("maxkey", MAXKEY).add("prefill", PREFILL_AMT).add("millis_to_run", MILLIS_TO_RUN).add("ops_per_thread", OPS_PER_THREAD)
+          .add("heap_list_size", HEAP_LIST_SIZE).add("counter_tsh", COUNTER_TSH).add("counter_max", COUNTER_MX).add("max_offset", LMAX_OFFSET)
+          .add("key_dist", KEY_DIST_NAMES[KEY_DIST]).add("key_dist_param", KEY_DIST_PARAM).add("timeline_interval_ms", TIMELINE_INTERVAL_MS);
+    if (BENCHMARK == 14) {
+        config.add("open_loop_rate", OPEN_LOOP_RATE).add("open_loop_arrival", OPEN_LOOP_ARRIVAL == OPEN_LOOP_ARRIVAL_POISSON ? "poisson" : "fixed");
+    } else if (BENCHMARK == 15 || BENCHMARK == 16) {
+        config.add("hold_dist", HOLD_DIST_NAMES[HOLD_DIST]).add("hold_mean", HOLD_MEAN);
+        if (BENCHMARK == 16) config.add("des_lps", DES_LPS).add("des_event_work", DES_EVENT_WORK);
+    }
+    if (BENCHMARK == 17) {
+        config.add("replay", TRACE_REPLAY).add("replay_timing", TRACE_REPLAY_TIMING);
+    }
+
 #ifdef USE_GSTATS
     GSTATS_PRINT;
     cout<<endl;
@@ -2234,6 +2875,8 @@ void printOutput() {
         } else {
             cout<<"Validation FAILURE: :( threadsKeySum = "<<threadsKeySum<<" dsKeySum="<<dsKeySum<<endl;
         }
+        validation.add("keysum_ok", threadsKeySum == dsKeySum).add("traversal_ok", validated)
+                  .add("threads_keysum", threadsKeySum).add("ds_keysum", (long long) dsKeySum);
 
         if (validated) {
             cout << "Validation OK: :) Traversal validated!\n\n";
@@ -2305,7 +2948,7 @@ void printOutput() {
                 total_ops += num_ops_phase;
                 prev_end_time = end_time_phase;
             }
-        } else if (BENCHMARK == 1 || BENCHMARK == 2 || BENCHMARK == 4) {
+        } else if (BENCHMARK == 1 || BENCHMARK == 2 || BENCHMARK == 4 || BENCHMARK == 17) {
             auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(glob.endTime - glob.startTime).count();
             glob.elapsedMillis = milliseconds;
             SECONDS_TO_RUN = (milliseconds)/1000.;
@@ -2346,6 +2989,150 @@ void printOutput() {
         COUTATOMIC("insert throughput             : "<<throughputInserts<<endl);
         COUTATOMIC("delmin throughput             : "<<throughputDelmin<<endl);
         COUTATOMIC("update throughput             : "<<throughputUpdates<<endl<<endl);
+        results.add("seconds", SECONDS_TO_RUN).add("total_inserts", totalInserts).add("total_delmin", totalDelMin)
+               .add("throughput", throughputUpdates).add("throughput_ins", throughputInserts).add("throughput_del", throughputDelmin)
+               .add("latency_ins_avg", insLatAvg).add("latency_del_avg", delLatAvg)
+               .add("latency_ins", latency_percentiles(latency_updates)).add("latency_del", latency_percentiles(latency_del));
+        if (BENCHMARK == 15 || BENCHMARK == 16) {
+            COUTATOMIC("hold increment distribution   : "<<HOLD_DIST_NAMES[HOLD_DIST]<<" (mean "<<HOLD_MEAN<<")"<<endl);
+            COUTATOMIC("key rebases                   : "<<hold_rebases<<endl);
+            results.add("key_rebases", hold_rebases);
+        }
+        if (BENCHMARK == 15) {
+            COUTATOMIC("hold throughput               : "<<(long long) (totalDelMin / SECONDS_TO_RUN)<<endl);
+        }
+        if (BENCHMARK == 16) {
+            long long violations = 0;
+            long long sim_time = 0;
+            for (int tid = 0; tid < THREADS; ++tid) {
+                violations += des_violations[tid*PREFETCH_SIZE_WORDS];
+            }
+            for (int i = 0; i < DES_LPS; ++i) {
+                sim_time = max(sim_time, des_lvt[i].load());
+            }
+            COUTATOMIC("PHOLD LPs                     : "<<DES_LPS<<" (work "<<DES_EVENT_WORK<<"/event)"<<endl);
+            COUTATOMIC("events/sec                    : "<<(long long) (totalDelMin / SECONDS_TO_RUN)<<endl);
+            COUTATOMIC("causality violations          : "<<violations<<" ("<<(totalDelMin ? (100. * violations / totalDelMin) : 0)<<"%)"<<endl);
+            COUTATOMIC("simulated time reached        : "<<sim_time<<endl<<endl);
+            results.add("causality_violations", violations).add("sim_time", sim_time);
+            delete[] des_lvt;
+        }
+        if (RANK_ERROR && BENCHMARK == 3) {
+            COUTATOMIC("rank error mean               : "<<rank_stats.rank_mean<<endl);
+            COUTATOMIC("rank error p50/p90/p99/max    : "<<rank_stats.rank_p50<<" / "<<rank_stats.rank_p90<<" / "<<rank_stats.rank_p99<<" / "<<rank_stats.rank_max<<endl);
+            COUTATOMIC("delay mean/max                : "<<rank_stats.delay_mean<<" / "<<rank_stats.delay_max<<endl);
+            COUTATOMIC("ranked delete-mins            : "<<rank_stats.delete_mins<<" ("<<rank_stats.unmatched<<" overlapped their insert)"<<endl<<endl);
+            json_record rank_rec;
+            rank_rec.add("delete_mins", rank_stats.delete_mins).add("unmatched", rank_stats.unmatched).add("mean", rank_stats.rank_mean)
+                    .add("p50", rank_stats.rank_p50).add("p90", rank_stats.rank_p90).add("p99", rank_stats.rank_p99).add("max", rank_stats.rank_max)
+                    .add("delay_mean", rank_stats.delay_mean).add("delay_max", rank_stats.delay_max);
+            results.add("rank_error", rank_rec);
+        }
+        if (LINCHECK && BENCHMARK == 3) {
+            if (lincheck_result.ok()) {
+                COUTATOMIC("Validation OK: :) history is consistent with a strict priority queue ("<<lincheck_result.delete_mins<<" delete-mins)"<<endl<<endl);
+            } else {
+                COUTATOMIC("Validation FAILURE: :( history violates strict priority queue order: "<<lincheck_result.order<<" order, "
+                        <<lincheck_result.empty<<" empty, "<<lincheck_result.phantom<<" phantom violation(s)"<<endl<<endl);
+            }
+            validation.add("lincheck_ok", lincheck_result.ok()).add("lincheck_order", lincheck_result.order)
+                      .add("lincheck_empty", lincheck_result.empty).add("lincheck_phantom", lincheck_result.phantom);
+        }
+        if (BENCHMARK == 17) {
+            long long late = 0;
+            for (int tid = 0; tid < THREADS; ++tid) {
+                late += trace_replay_late[tid*PREFETCH_SIZE_WORDS];
+            }
+            COUTATOMIC("replayed trace                : "<<TRACE_REPLAY<<(TRACE_REPLAY_TIMING ? " (recorded timing)" : " (back to back)")<<endl);
+            if (TRACE_REPLAY_TIMING) {
+                COUTATOMIC("ops over 1 ms behind the trace: "<<late<<" ("<<(totalUpdates ? (100. * late / totalUpdates) : 0)<<"%)"<<endl);
+                results.add("replay_late", late);
+            }
+            COUTATOMIC(endl);
+        }
+        if (BENCHMARK == 14) {
+            long long hist[OPEN_LOOP_BUCKETS] = {0,};
+            long long count = 0;
+            long long late = 0;
+            for (int tid = 0; tid < THREADS; ++tid) {
+                for (int i = 0; i < OPEN_LOOP_BUCKETS; ++i) {
+                    hist[i] += open_loop_hist[tid][i];
+                    count += open_loop_hist[tid][i];
+                }
+                late += open_loop_late[tid*PREFETCH_SIZE_WORDS];
+            }
+            const double percentiles[] = {50, 90, 99, 99.9, 99.99, 100};
+            const char * names[] = {"p50", "p90", "p99", "p99.9", "p99.99", "max"};
+            COUTATOMIC("offered throughput            : "<<(long long) OPEN_LOOP_RATE<<(OPEN_LOOP_ARRIVAL == OPEN_LOOP_ARRIVAL_POISSON ? " (poisson)" : " (fixed)")<<endl);
+            COUTATOMIC("ops behind schedule           : "<<(count ? (100. * late / count) : 0)<<"%"<<endl);
+            json_record open_loop;
+            open_loop.add("ops", count).add("late", late);
+            int bucket = 0;
+            long long seen = 0;
+            for (int p = 0; p < 6; ++p) {
+                long long rank = max(1LL, (long long) ceil(percentiles[p] / 100. * count));
+                while (count && seen + hist[bucket] < rank) {
+                    seen += hist[bucket++];
+                }
+                COUTATOMIC("latency "<<names[p]<<string(22 - strlen(names[p]), ' ')<<": "<<(count ? open_loop_bucket_latency(bucket) : 0)<<endl);
+                open_loop.add(names[p], count ? open_loop_bucket_latency(bucket) : 0);
+            }
+            results.add("latency_open_loop", open_loop);
+            COUTATOMIC(endl);
+        }
+        if (TIMELINE_INTERVAL_MS > 0 && (BENCHMARK == 3 || BENCHMARK == 5)) {
+            // merge the threads' intervals; the last interval with any ops is partial, so it is printed but not analyzed
+            vector<long long> inserts(timeline_intervals), delmins(timeline_intervals), latency(timeline_intervals);
+            int used = 0;
+            for (int tid = 0; tid < THREADS; ++tid) {
+                for (int i = 0; i < timeline_intervals; ++i) {
+                    inserts[i] += timeline[tid][i].inserts;
+                    delmins[i] += timeline[tid][i].delmins;
+                    latency[i] += timeline[tid][i].latency;
+                    if (timeline[tid][i].inserts + timeline[tid][i].delmins > 0) used = max(used, i + 1);
+                }
+                delete[] timeline[tid];
+            }
+            inserts.resize(used);
+            delmins.resize(used);
+            latency.resize(used);
+            vector<long long> throughput(used);
+            COUTATOMIC("timeline (ms, inserts, delmins, throughput, avg latency):"<<endl);
+            for (int i = 0; i < used; ++i) {
+                long long ops = inserts[i] + delmins[i];
+                throughput[i] = ops * 1000 / TIMELINE_INTERVAL_MS;
+                COUTATOMIC("    "<<(long long) i * TIMELINE_INTERVAL_MS<<" "<<inserts[i]<<" "<<delmins[i]<<" "<<throughput[i]<<" "<<(ops ? latency[i] / ops : 0)<<endl);
+            }
+
+            // steady state starts at the first window of TIMELINE_STEADY_WINDOW full intervals whose throughput varies
+            // by less than TIMELINE_STEADY_CV; throughput is then reported over everything from there to the end
+            int full = used - 1;
+            int steady = -1;
+            for (int k = 0; k + TIMELINE_STEADY_WINDOW <= full; ++k) {
+                double mean = 0, var = 0;
+                for (int i = k; i < k + TIMELINE_STEADY_WINDOW; ++i) mean += throughput[i];
+                mean /= TIMELINE_STEADY_WINDOW;
+                for (int i = k; i < k + TIMELINE_STEADY_WINDOW; ++i) var += (throughput[i] - mean) * (throughput[i] - mean);
+                if (mean > 0 && sqrt(var / TIMELINE_STEADY_WINDOW) < TIMELINE_STEADY_CV * mean) {
+                    steady = k;
+                    break;
+                }
+            }
+            json_record timeline_rec;
+            timeline_rec.add("interval_ms", TIMELINE_INTERVAL_MS).add("inserts", inserts).add("delmins", delmins).add("latency_sum", latency);
+            if (steady >= 0) {
+                long long ops = 0;
+                for (int i = steady; i < full; ++i) ops += inserts[i] + delmins[i];
+                long long steady_throughput = ops * 1000 / ((long long) (full - steady) * TIMELINE_INTERVAL_MS);
+                COUTATOMIC("steady state reached at       : "<<(long long) steady * TIMELINE_INTERVAL_MS<<" ms"<<endl);
+                COUTATOMIC("steady-state throughput       : "<<steady_throughput<<endl<<endl);
+                timeline_rec.add("steady_start_ms", (long long) steady * TIMELINE_INTERVAL_MS).add("steady_throughput", steady_throughput);
+            } else {
+                COUTATOMIC("steady state reached at       : never (no "<<TIMELINE_STEADY_WINDOW<<" consecutive intervals within "<<TIMELINE_STEADY_CV * 100<<"%)"<<endl<<endl);
+                timeline_rec.add_null("steady_start_ms").add_null("steady_throughput");
+            }
+            results.add("timeline", timeline_rec);
+        }
         #if defined(PIPQ_STRICT) || defined(LLSL_TEST) || defined(PIPQ_STRICT_ATOMIC)
         string numMoves = ds->getNumMoves();
         string numIns = ds->getNumIns();
@@ -2375,6 +3162,9 @@ void printOutput() {
         COUTATOMIC("avg # nodes traversed         : "<<numTrav<<endl);
         COUTATOMIC("# coord upsert                : "<<numCoordUp<<endl<<endl);
 
+        pipq_paths.add("moves", std::stol(numMoves)).add("leader_inserts", std::stol(numIns)).add("fast", std::stol(numFast))
+                  .add("helping", std::stol(numHelping)).add("traversed_avg", std::stod(numTrav)).add("coord_upsert", std::stol(numCoordUp));
+
         COUTATOMIC("Thpt Slowest  Slow  Fast  Helping  Traversed  Coord-Up Lat-INS Lat-DEL\n");
         COUTATOMIC(throughputUpdates << " " << numMoves << " " << numIns << " " << numFast << " " << numHelping << " " << numTrav << " " << numCoordUp << " " << insLatAvg << " " << delLatAvg << "\n");
         
@@ -2396,12 +3186,31 @@ void printOutput() {
     #endif
     COUTATOMIC("data structure size stats     : "<<ds_size<<endl);
     COUTATOMIC(endl);
+    results.add("elapsed_millis", glob.elapsedMillis).add("ds_size", ds_size);
     
 #if defined(USE_DEBUGCOUNTERS) || defined(USE_GSTATS)
     cout<<"begin papi_print_counters..."<<endl;
     papi_print_counters(totalAll);
     cout<<"end papi_print_counters."<<endl;
 #endif
+#ifdef USE_PAPI
+    for (int i = 0, j = 0; i < nall_cpu_counters; i++) {
+        if (PAPI_query_event(all_cpu_counters[i]) != PAPI_OK) continue;
+        papi.add(all_cpu_counters_strings[i].c_str(), counter_values[j++]);
+    }
+#endif
+
+    if (!JSON_OUTPUT.empty()) {
+        json_record record;
+        record.add("config", config).add("results", results).add("validation", validation);
+      #if defined(PIPQ_STRICT) || defined(LLSL_TEST) || defined(PIPQ_STRICT_ATOMIC)
+        record.add("pipq_paths", pipq_paths);
+      #endif
+        record.add("papi", papi);
+        if (!record.append_to(JSON_OUTPUT.c_str())) {
+            cout<<"ERROR: could not write results to "<<JSON_OUTPUT<<endl;
+        }
+    }
     
     // free ds
     cout<<"begin delete ds..."<<endl;
@@ -2439,6 +3248,21 @@ int main(int argc, char** argv) {
 
     COUNTER_TSH = 10;
     COUNTER_MX = 20;
+
+    OPEN_LOOP_RATE = 0;
+    TIMELINE_INTERVAL_MS = 0;
+    TRACE_REPLAY_TIMING = false;
+    RANK_ERROR = false;
+    LINCHECK = false;
+    OPEN_LOOP_ARRIVAL = OPEN_LOOP_ARRIVAL_POISSON;
+
+    HOLD_DIST = HOLD_DIST_EXPONENTIAL;
+    HOLD_MEAN = 1000;
+    DES_LPS = 1024;
+    DES_EVENT_WORK = 100;
+
+    KEY_DIST = KEY_DIST_UNIFORM;
+    KEY_DIST_PARAM = -1;
     
     // read command line args
     // example args: -i 50 -d 50 -k 10000 -o 100000 -p -b 0 -t 3000 -n 1 -bind 0,4,8,12,16,20,24,28,32,36,40,44,48,52,56,60,64,68,72,76,80,84,88,92,96,100,104,108,112,116,120,124,128,132,136,140,144,148,152,156,160,164,168,172,176,180,184,188,1,5,9,13,17,21,25,29,33,37,41,45,49,53,57,61,65,69,73,77,81,85,89,93,97,101,105,109,113,117,121,125,129,133,137,141,145,149,153,157,161,165,169,173,177,181,185,189,2,6,10,14,18,22,26,30,34,38,42,46,50,54,58,62,66,70,74,78,82,86,90,94,98,102,106,110,114,118,122,126,130,134,138,142,146,150,154,158,162,166,170,174,178,182,186,190,3,7,11,15,19,23,27,31,35,39,43,47,51,55,59,63,67,71,75,79,83,87,91,95,99,103,107,111,115,119,123,127,131,135,139,143,147,151,155,159,163,167,171,175,179,183,187,191
@@ -2486,6 +3310,60 @@ int main(int argc, char** argv) {
             cout << "parsed custom binding: " << argv[i] << endl;
         } else if (strcmp(argv[i], "-phased") == 0) {
             parse_mixed_workload(argv[++i]);
+        } else if (strcmp(argv[i], "-rate") == 0) {
+            OPEN_LOOP_RATE = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-arrival") == 0) {
+            ++i;
+            if (strcmp(argv[i], "poisson") == 0) {
+                OPEN_LOOP_ARRIVAL = OPEN_LOOP_ARRIVAL_POISSON;
+            } else if (strcmp(argv[i], "fixed") == 0) {
+                OPEN_LOOP_ARRIVAL = OPEN_LOOP_ARRIVAL_FIXED;
+            } else {
+                cout<<"bad arrival process "<<argv[i]<<" (poisson or fixed)"<<endl;
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-hold") == 0) {
+            ++i;
+            HOLD_DIST = -1;
+            for (int d = 0; d < 4; ++d) {
+                if (strcmp(argv[i], HOLD_DIST_NAMES[d]) == 0) HOLD_DIST = d;
+            }
+            if (HOLD_DIST < 0) {
+                cout<<"bad hold distribution "<<argv[i]<<" (exponential, uniform, bimodal or triangular)"<<endl;
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-hmean") == 0) {
+            HOLD_MEAN = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-lps") == 0) {
+            DES_LPS = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-ework") == 0) {
+            DES_EVENT_WORK = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-dist") == 0) {
+            ++i;
+            KEY_DIST = -1;
+            for (int d = 0; d < NUM_KEY_DISTS; ++d) {
+                if (strcmp(argv[i], KEY_DIST_NAMES[d]) == 0) KEY_DIST = d;
+            }
+            if (KEY_DIST < 0) {
+                cout<<"bad key distribution "<<argv[i]<<" (uniform, zipf, ascending, descending, disjoint, clustered or duplicates)"<<endl;
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-dparam") == 0) {
+            KEY_DIST_PARAM = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-timeline") == 0) {
+            TIMELINE_INTERVAL_MS = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-record") == 0) {
+            TRACE_RECORD = argv[++i];
+        } else if (strcmp(argv[i], "-replay") == 0) {
+            TRACE_REPLAY = argv[++i];
+        } else if (strcmp(argv[i], "-replay_timing") == 0) {
+            TRACE_REPLAY_TIMING = true;
+        } else if (strcmp(argv[i], "-rank") == 0) {
+            RANK_ERROR = true;
+        } else if (strcmp(argv[i], "-lincheck") == 0) {
+            LINCHECK = true;
+        } else if (strcmp(argv[i], "-json") == 0) {
+            JSON_OUTPUT = argv[++i];
         } else {
             cout<<"bad argument "<<argv[i]<<endl;
             exit(1);
@@ -2515,6 +3393,40 @@ int main(int argc, char** argv) {
     if (BENCHMARK == 4) {
         OPS_PER_THREAD = OPS_PER_THREAD / (THREADS);
     }
+    key_distribution_init();
+    if (BENCHMARK == 14 && OPEN_LOOP_RATE <= 0) {
+        cout<<"Open-loop benchmark needs a target rate (-rate <ops/sec>)"<<endl;
+        exit(1);
+    }
+    if ((!TRACE_RECORD.empty() || RANK_ERROR || LINCHECK) && BENCHMARK != 3) {
+        cout<<"Only the mixed workload (-b 3) can be recorded (-record), ranked (-rank) or checked (-lincheck)"<<endl;
+        exit(1);
+    }
+    if (BENCHMARK == 17) {
+        if (TRACE_REPLAY.empty() || !trace_replay.open(TRACE_REPLAY.c_str())) {
+            cout<<"Trace replay needs a valid trace (-replay <file>)"<<endl;
+            exit(1);
+        }
+        if (trace_replay.threads() != THREADS) {
+            cout<<"Trace was recorded with "<<trace_replay.threads()<<" threads; replay it with -n "<<trace_replay.threads()<<endl;
+            exit(1);
+        }
+        long long max_key = 0;
+        for (int tid = 0; tid < THREADS; ++tid) {
+            for (uint64_t i = 0; i < trace_replay.count(tid); ++i) {
+                const pq_trace_record * rec = &trace_replay.thread_records(tid)[i];
+                if (rec->op != PQ_TRACE_DELETE_MIN) max_key = max(max_key, (long long) rec->key);
+            }
+        }
+        if (max_key + 1 > INT_MAX) {
+            cout<<"Trace keys go up to "<<max_key<<", which does not fit the microbenchmark's int keys"<<endl;
+            exit(1);
+        }
+        if (max_key + 1 > MAXKEY) {
+            cout<<"Raising MAXKEY to "<<max_key + 1<<" to cover the trace's keys"<<endl;
+            MAXKEY = max_key + 1;
+        }
+    }
 
     pthread_barrier_init(&WaitForAll, NULL, THREADS);
     
@@ -2532,6 +3444,27 @@ int main(int argc, char** argv) {
     PRINTI(BENCHMARK);
     PRINTI(OPS_PER_THREAD);
     PRINTI(HEAP_LIST_SIZE);
+    cout<<"KEY_DIST="<<KEY_DIST_NAMES[KEY_DIST]<<endl;
+    PRINTI(KEY_DIST_PARAM);
+    if (BENCHMARK == 14) {
+        PRINTI(OPEN_LOOP_RATE);
+        PRINTI(OPEN_LOOP_ARRIVAL);
+    }
+    if (BENCHMARK == 15 || BENCHMARK == 16) {
+        PRINTI(HOLD_DIST);
+        PRINTI(HOLD_MEAN);
+    }
+    if (BENCHMARK == 16) {
+        PRINTI(DES_LPS);
+        PRINTI(DES_EVENT_WORK);
+    }
+    if (TIMELINE_INTERVAL_MS > 0) {
+        PRINTI(TIMELINE_INTERVAL_MS);
+    }
+    if (BENCHMARK == 17) {
+        PRINTI(TRACE_REPLAY);
+        PRINTI(TRACE_REPLAY_TIMING);
+    }
 #ifdef WIDTH_SEQ
     PRINTI(WIDTH_SEQ);
 #endif
@@ -2561,6 +3494,7 @@ int main(int argc, char** argv) {
     DS = "CBPQ";
   #endif
     PRINTI(DS);
+    DS_NAME = DS;
 
 
     pthread_barrier_init(&WaitForThreads, NULL, THREADS);
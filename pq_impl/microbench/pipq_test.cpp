@@ -0,0 +1,567 @@
+/*
+ * File:   pipq_test.cpp
+ *
+ * Standalone tests of the PIPQ features outside of the benchmark harness (no thread pinning, NUMA zones or PAPI).
+ * Every test builds its own pq with all threads in zone 0, runs, and then drains the pq from one thread: the
+ * drain has to come out in key order and, together with what the test deleted, hold exactly what it inserted.
+ *
+ * Usage: pipq_test [test name ...] (default: all tests)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include "../recordmgr/debugprinting.h"
+#include "pipq_strict_impl.h"
+
+using namespace pq_ns;
+
+#define TEST_HEAP_LIST_SIZE 64 // small, so heaps span several lists
+#define TEST_ZONE_CPU 0 // register_thread() cpu: zone 0
+
+typedef pq<long long> test_pq;
+
+static std::atomic<int> failures(0); // CHECK runs in the test threads too
+
+#define CHECK(cond, msg) \
+{ \
+    if (!(cond)) { \
+        printf("    FAILED: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+        failures++; \
+    } \
+}
+
+static test_pq * new_pq(int threads) {
+    test_pq * q = new test_pq(TEST_HEAP_LIST_SIZE, 0, 0, threads, 3, 10, 32);
+    q->PQInit();
+    return q;
+}
+
+// delete-mins until the pq is empty; the keys have to come out in order
+static std::vector<int> drain(test_pq * q) {
+    std::vector<int> keys;
+    while (true) {
+        long long val;
+        int key = q->hier_delete(&val);
+        if (key == EMPTY) {
+            break;
+        }
+        CHECK(val == key, "value returned with the wrong key");
+        keys.push_back(key);
+    }
+    CHECK(std::is_sorted(keys.begin(), keys.end()), "drain out of key order");
+    return keys;
+}
+
+// the leader holds each key at most once
+static bool leader_keys_unique(test_pq * q) {
+    k_t prev = KEY_MIN;
+    for (node__t * node = q->leader_set->head->next; (node__t*) get_unmarked_reference(node) != q->leader_set->tail;
+            node = ((node__t*) get_unmarked_reference(node))->next) {
+        if (is_marked_reference(node)) continue;
+        if (node->key <= prev) return false;
+        prev = node->key;
+    }
+    return true;
+}
+
+// expected and found are compared as multisets
+static void check_same(std::vector<int> expected, std::vector<int> found, const char * msg) {
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+    if (expected != found) {
+        printf("    FAILED: %s: %zu expected, %zu found\n", msg, expected.size(), found.size());
+        failures++;
+    }
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      JOIN / LEAVE                            */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define JOIN_THREADS 8
+#define JOIN_ROUNDS 50
+#define JOIN_OPS 200
+
+struct join_arg {
+    test_pq * q;
+    int id;
+    std::atomic<int> * round_start;
+    std::vector<int> inserted;
+    std::vector<int> deleted;
+};
+
+// each round every thread registers (all at once), inserts, deletes half as many and leaves again
+static void * join_leave_thread(void * arg) {
+    join_arg * a = (join_arg *) arg;
+    for (int round = 0; round < JOIN_ROUNDS; round++) {
+        while (a->round_start->load() < round) { }
+        int slot = a->q->register_thread(TEST_ZONE_CPU);
+        CHECK(slot >= 0, "register_thread() found no free slot");
+        if (slot < 0) {
+            continue;
+        }
+        for (int i = 0; i < JOIN_OPS; i++) {
+            int key = 1 + (round * JOIN_THREADS + a->id) * JOIN_OPS + i; // unique
+            a->q->hier_insert_local(key, key);
+            a->inserted.push_back(key);
+            if (i % 2 == 1) {
+                long long val;
+                int del = a->q->hier_delete(&val);
+                if (del != EMPTY) {
+                    a->deleted.push_back(del);
+                }
+            }
+        }
+        a->q->unregister_thread();
+    }
+    return NULL;
+}
+
+static void test_join_leave() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0); // the main thread keeps slot 0 - a peer for the leaving threads to hand their heaps to
+    std::atomic<int> round_start(-1);
+    join_arg args[JOIN_THREADS];
+    pthread_t threads[JOIN_THREADS];
+    for (int i = 0; i < JOIN_THREADS; i++) {
+        args[i].q = q;
+        args[i].id = i;
+        args[i].round_start = &round_start;
+        pthread_create(&threads[i], NULL, join_leave_thread, &args[i]);
+    }
+    for (int round = 0; round < JOIN_ROUNDS; round++) {
+        round_start.store(round);
+        usleep(1000);
+    }
+    for (int i = 0; i < JOIN_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    std::vector<int> inserted, found = drain(q);
+    for (int i = 0; i < JOIN_THREADS; i++) {
+        inserted.insert(inserted.end(), args[i].inserted.begin(), args[i].inserted.end());
+        found.insert(found.end(), args[i].deleted.begin(), args[i].deleted.end());
+    }
+    check_same(inserted, found, "elements lost or duplicated across join/leave");
+    for (int idx = 1; idx < NUMA_ZONE_THREADS; idx++) {
+        CHECK(q->get_slot_status(0)[idx] == SLOT_FREE, "slot not released");
+    }
+    q->PQDeinit();
+    delete q;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      IDLE WORKER SCAN                        */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define IDLE_THREADS 3
+#define IDLE_ELEMENTS 2000
+#define IDLE_ROUNDS (4 * IDLE_SCAN_INTERVAL * IDLE_SCAN_ROUNDS)
+
+struct idle_arg {
+    test_pq * q;
+    int tid;
+    std::vector<int> inserted;
+};
+
+// fills the worker heap and goes idle for good, still owning its slot
+static void * idle_thread(void * arg) {
+    idle_arg * a = (idle_arg *) arg;
+    a->q->threadInit(a->tid);
+    for (int i = 0; i < IDLE_ELEMENTS; i++) {
+        int key = 1000000 + a->tid * IDLE_ELEMENTS + i; // above every key of the busy thread
+        a->q->hier_insert_local(key, key);
+        a->inserted.push_back(key);
+    }
+    return NULL;
+}
+
+// the busy thread only deletes its own (smaller) keys, so the idle heaps only empty if its scans adopt them
+static void test_idle_scan() {
+    test_pq * q = new_pq(1 + IDLE_THREADS);
+    idle_arg args[IDLE_THREADS];
+    pthread_t threads[IDLE_THREADS];
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        args[i].q = q;
+        args[i].tid = 1 + i;
+        pthread_create(&threads[i], NULL, idle_thread, &args[i]);
+    }
+    q->threadInit(0);
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    std::vector<int> inserted, found;
+    for (int i = 0; i < IDLE_ROUNDS; i++) {
+        int key = 1 + i;
+        q->hier_insert_local(key, key);
+        inserted.push_back(key);
+        long long val;
+        int del = q->hier_delete(&val);
+        CHECK(del != EMPTY, "busy thread's delete-min found the pq empty");
+        if (del != EMPTY) {
+            found.push_back(del);
+        }
+    }
+    for (int i = 0; i < IDLE_THREADS; i++) {
+        CHECK(q->get_heap_mapping(args[i].tid, 0)->size == 0, "idle worker heap not adopted");
+        inserted.insert(inserted.end(), args[i].inserted.begin(), args[i].inserted.end());
+    }
+    std::vector<int> drained = drain(q);
+    found.insert(found.end(), drained.begin(), drained.end());
+    check_same(inserted, found, "elements lost or duplicated by adoption");
+    q->PQDeinit();
+    delete q;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      MELD                                    */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define MELD_ELEMENTS 3000
+
+// fills a pq from the calling thread with step, 2 * step, ...; the thread-local slot is rebound to q first
+static void fill(test_pq * q, int step, std::vector<int> & inserted) {
+    q->threadInit(0);
+    for (int i = 1; i <= MELD_ELEMENTS; i++) {
+        q->hier_insert_local(i * step, i * step);
+        inserted.push_back(i * step);
+    }
+}
+
+// the two pqs share every sixth key, in the leaders as well as the heaps; PIPQ keeps one element per key in the
+// leader and accounts for the others in repeat_keys, so the drain holds every key and the key sums match
+static void test_meld() {
+    test_pq * a = new_pq(1);
+    test_pq * b = new_pq(1);
+    std::vector<int> inserted;
+    fill(a, 3, inserted);
+    fill(b, 2, inserted);
+    a->meld(*b);
+    CHECK(leader_keys_unique(a), "meld left a key twice in the leader");
+
+    a->threadInit(0);
+    std::vector<int> found = drain(a);
+    long long inserted_sum = 0, found_sum = 0;
+    for (int key : inserted) inserted_sum += key;
+    for (int key : found) found_sum += key;
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) found_sum += a->repeat_keys[i];
+    CHECK(found_sum == inserted_sum, "key sum changed by meld");
+    std::sort(inserted.begin(), inserted.end());
+    inserted.erase(std::unique(inserted.begin(), inserted.end()), inserted.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    check_same(inserted, found, "keys lost by meld");
+
+    b->threadInit(0);
+    CHECK(drain(b).empty(), "melded pq not left empty");
+    a->PQDeinit();
+    b->PQDeinit();
+    delete a;
+    delete b;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      INSERT BATCH                            */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define BATCH_ELEMENTS 3000
+
+// a shuffled batch with keys below, between and above the slot's existing elements: only its new minima may reach the
+// leader, which stays within COUNTER_MAX, and everything comes out in order
+static void test_insert_batch() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0);
+    std::vector<int> inserted;
+    for (int key = BATCH_ELEMENTS; key < 2 * BATCH_ELEMENTS; key += 2) {
+        q->hier_insert_local(key, key);
+        inserted.push_back(key);
+    }
+    std::vector<test_pq::PQ_Node> batch;
+    for (int key = 1; key <= 3 * BATCH_ELEMENTS; key += 3) {
+        if (key % 2 == 0 && key >= BATCH_ELEMENTS && key < 2 * BATCH_ELEMENTS) continue; // already in the pq
+        batch.push_back({key, key});
+        inserted.push_back(key);
+    }
+    std::mt19937 rng(1);
+    std::shuffle(batch.begin(), batch.end(), rng);
+    CHECK(q->hier_insert_batch(batch.data(), batch.size()) == (int) batch.size(), "batch elements not inserted");
+    CHECK(q->get_counters(0, 0)->count <= 10, "batch pushed the leader past COUNTER_MAX"); // new_pq's counter max
+    CHECK(leader_keys_unique(q), "leader holds a key twice");
+    check_same(inserted, drain(q), "batch elements lost or out of order");
+    q->PQDeinit();
+    delete q;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      CANCEL                                  */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define CANCEL_ELEMENTS 2000
+
+// target is a live node of the leader list
+static bool leader_holds(test_pq * q, node__t * target) {
+    for (node__t * node = q->leader_set->head->next; (node__t*) get_unmarked_reference(node) != q->leader_set->tail;
+            node = ((node__t*) get_unmarked_reference(node))->next) {
+        if (!is_marked_reference(node) && node == target) return true;
+    }
+    return false;
+}
+
+// cancels every third element, leader elements (starting with the slot's largest) as well as heap elements
+static void test_cancel() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0);
+    std::vector<int> kept;
+    std::vector<test_pq::PQ_Handle> handles(CANCEL_ELEMENTS + 1);
+    for (int key = 1; key <= CANCEL_ELEMENTS; key++) {
+        q->hier_insert_local(key, key, &handles[key]);
+    }
+    LeaderLargest * last_ptr = q->get_last_ptr(0, 0);
+    CHECK(last_ptr->largest_ptr, "no leader elements to cancel");
+    int largest = last_ptr->largest_ptr->key;
+    CHECK(q->remove(handles[largest]), "leader element not cancelled");
+    CHECK(!last_ptr->largest_ptr || (last_ptr->largest_ptr->key < largest && leader_holds(q, last_ptr->largest_ptr)),
+            "largest ptr left on the cancelled leader element");
+    for (int key = 1; key <= CANCEL_ELEMENTS; key++) {
+        if (key == largest) continue;
+        if (key % 3 == 0) {
+            CHECK(q->remove(handles[key]), "element not cancelled");
+        } else {
+            kept.push_back(key);
+        }
+    }
+    for (int key = CANCEL_ELEMENTS + 1; key <= 2 * CANCEL_ELEMENTS; key++) { // inserts compare against the largest ptr
+        q->hier_insert_local(key, key);
+        kept.push_back(key);
+    }
+    check_same(kept, drain(q), "cancelled elements returned or others lost");
+    q->PQDeinit();
+    delete q;
+}
+
+// a heap that is mostly cancelled is rebuilt by its owner's inserts and keeps no tombstones
+static void test_compaction() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0);
+    std::vector<int> kept;
+    std::vector<test_pq::PQ_Handle> handles(COMPACT_INTERVAL + 1);
+    for (int key = 1; key <= COMPACT_INTERVAL; key++) {
+        q->hier_insert_local(key, key, &handles[key]);
+    }
+    int before = q->t_local_heap->size;
+    for (int key = COMPACT_INTERVAL / 2; key <= COMPACT_INTERVAL; key++) { // all in the heap, above the leader
+        CHECK(q->remove(handles[key]), "heap element not cancelled");
+    }
+    CHECK(q->t_local_heap->num_tombstones == COMPACT_INTERVAL / 2 + 1, "cancelled heap elements not tombstoned");
+    for (int key = 1; key < COMPACT_INTERVAL / 2; key++) {
+        kept.push_back(key);
+    }
+    for (int key = COMPACT_INTERVAL + 1; key <= 2 * COMPACT_INTERVAL; key++) {
+        q->hier_insert_local(key, key);
+        kept.push_back(key);
+    }
+    CHECK(q->t_local_heap->num_tombstones == 0, "compaction left tombstones");
+    CHECK(q->t_local_heap->size < before + COMPACT_INTERVAL - COMPACT_INTERVAL / 2, "compaction kept cancelled elements");
+    check_same(kept, drain(q), "compaction lost elements");
+    q->PQDeinit();
+    delete q;
+}
+
+#define STALE_POPS 10
+
+// cancelling an element that was already returned fails and leaves nothing behind for a later equal element
+static void test_stale_handle() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0);
+    std::vector<int> kept;
+    std::vector<test_pq::PQ_Handle> handles(CANCEL_ELEMENTS + 1);
+    for (int key = 1; key <= CANCEL_ELEMENTS; key++) {
+        q->hier_insert_local(key, key, &handles[key]);
+        if (key > STALE_POPS) kept.push_back(key);
+    }
+    for (int key = 1; key <= STALE_POPS; key++) {
+        long long val;
+        CHECK(q->hier_delete(&val) == key, "delete-min out of order");
+    }
+    CHECK(!q->remove(handles[1]), "cancelled an element that was already returned");
+    CHECK(!q->remove({CANCEL_ELEMENTS + 1, CANCEL_ELEMENTS + 1, 0, 0}), "cancelled an element that was never inserted");
+    q->hier_insert_local(1, 1);
+    kept.push_back(1);
+    check_same(kept, drain(q), "stale cancel dropped a later element");
+    q->PQDeinit();
+    delete q;
+}
+
+#define ADOPT_ELEMENTS 1000
+
+struct adopt_arg {
+    test_pq * q;
+    std::vector<test_pq::PQ_Handle> handles;
+};
+
+// registers, fills its heap and leaves, so a zone peer takes over its elements
+static void * adopt_thread(void * arg) {
+    adopt_arg * a = (adopt_arg *) arg;
+    int slot = a->q->register_thread(TEST_ZONE_CPU);
+    CHECK(slot > 0, "register_thread() did not give the thread a slot of its own");
+    for (int key = 1; key <= ADOPT_ELEMENTS; key++) {
+        test_pq::PQ_Handle handle;
+        a->q->hier_insert_local(key, key, &handle);
+        a->handles.push_back(handle);
+    }
+    a->q->unregister_thread();
+    return NULL;
+}
+
+// handles keep working after their slot's heap was handed to a peer
+static void test_cancel_adopted() {
+    test_pq * q = new_pq(1);
+    q->threadInit(0); // the peer for the leaving thread
+    adopt_arg arg;
+    arg.q = q;
+    pthread_t thread;
+    pthread_create(&thread, NULL, adopt_thread, &arg);
+    pthread_join(thread, NULL);
+
+    std::vector<int> kept;
+    for (test_pq::PQ_Handle & handle : arg.handles) {
+        if (handle.key % 2 == 1) {
+            CHECK(q->remove(handle), "adopted element not cancelled");
+        } else {
+            kept.push_back(handle.key);
+        }
+    }
+    check_same(kept, drain(q), "cancelled adopted elements returned or others lost");
+    q->PQDeinit();
+    delete q;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      CHECKPOINT / RESTORE                    */
+/*                                                              */
+/*         --------------------------------------------         */
+
+#define SNAPSHOT_ELEMENTS 3000
+
+struct snapshot_arg {
+    test_pq * q;
+    test_pq::PQ_Handle * handles; // by key, the thread fills in the odd ones
+};
+
+// fills slot 1 with the odd keys, so the checkpoint holds more than one heap and leader slot
+static void * snapshot_thread(void * arg) {
+    snapshot_arg * a = (snapshot_arg *) arg;
+    a->q->threadInit(1);
+    for (int key = 1; key <= SNAPSHOT_ELEMENTS; key += 2) {
+        a->q->hier_insert_local(key, key, &a->handles[key]);
+    }
+    return NULL;
+}
+
+// checkpoint a pq that has seen inserts, delete-mins and cancels, restore it into a fresh pq (with a different heap
+// list size) and drain both: they have to return the same elements in the same order
+static void test_snapshot() {
+    test_pq * a = new_pq(2);
+    std::vector<test_pq::PQ_Handle> handles(SNAPSHOT_ELEMENTS + 1);
+    snapshot_arg arg = {a, handles.data()};
+    pthread_t thread;
+    pthread_create(&thread, NULL, snapshot_thread, &arg);
+    a->threadInit(0);
+    for (int key = 2; key <= SNAPSHOT_ELEMENTS; key += 2) {
+        a->hier_insert_local(key, key, &handles[key]);
+    }
+    pthread_join(thread, NULL);
+    for (int i = 0; i < SNAPSHOT_ELEMENTS / 10; i++) {
+        long long val;
+        a->hier_delete(&val);
+    }
+    for (int key = SNAPSHOT_ELEMENTS / 2; key <= SNAPSHOT_ELEMENTS; key += 7) {
+        a->remove(handles[key]);
+    }
+
+    char path[] = "/tmp/pipq_test.XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0, "cannot create the checkpoint file");
+    close(fd);
+    CHECK(a->checkpoint(path), "checkpoint failed");
+    test_pq * b = new test_pq(2 * TEST_HEAP_LIST_SIZE, 0, 0, 1, 3, 10, 32);
+    b->PQInit();
+    CHECK(b->restore(path), "restore failed");
+    unlink(path);
+
+    std::vector<int> a_keys = drain(a);
+    b->threadInit(0);
+    std::vector<int> b_keys = drain(b);
+    CHECK(!a_keys.empty(), "nothing left to checkpoint");
+    CHECK(a_keys == b_keys, "restored pq returns different elements");
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        CHECK(a->repeat_keys[i] == b->repeat_keys[i], "repeat keys not restored");
+    }
+    a->PQDeinit();
+    b->PQDeinit();
+    delete a;
+    delete b;
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      MAIN                                    */
+/*                                                              */
+/*         --------------------------------------------         */
+
+struct test_case {
+    const char * name;
+    void (*run)();
+};
+
+static test_case tests[] = {
+    {"join_leave", test_join_leave},
+    {"idle_scan", test_idle_scan},
+    {"meld", test_meld},
+    {"insert_batch", test_insert_batch},
+    {"cancel", test_cancel},
+    {"compaction", test_compaction},
+    {"stale_handle", test_stale_handle},
+    {"cancel_adopted", test_cancel_adopted},
+    {"snapshot", test_snapshot},
+};
+
+int main(int argc, char** argv) {
+    int run = 0;
+    for (const test_case & t : tests) {
+        bool selected = (argc == 1);
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], t.name) == 0) selected = true;
+        }
+        if (!selected) continue;
+        int before = failures;
+        printf("%s\n", t.name);
+        t.run();
+        printf("%s: %s\n", t.name, failures == before ? "OK" : "FAILED");
+        run++;
+    }
+    if (run == 0) {
+        printf("usage: %s [test name ...]\n", argv[0]);
+        return 2;
+    }
+    printf("%d test(s), %s\n", run, failures == 0 ? "all passed" : "FAILURES");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+/*
+ * File:   pq_adapter.h
+ *
+ * Interface of the multi-structure benchmark binary (make pqbench) to its queues. Each queue has an adapter class in
+ * its own pq_adapter_<ds>.cpp, which is the only translation unit that includes that queue's headers, so the queues
+ * (and their header-defined globals) never meet in one translation unit. That file instantiates run_workload
+ * (pq_workload.h) with its adapter and exports only the run_<ds>_bench entry below, so the workload loop calls the
+ * queue's insert and delete-min directly, as main.cpp's INSERT_FUNC / REMOVE_MIN_FUNC do.
+ */
+
+#ifndef PQ_ADAPTER_H
+#define PQ_ADAPTER_H
+
+struct pq_adapter_config {
+    int threads;
+    int max_key;
+    int heap_list_size; // PIPQ only
+    int max_offset; // PIPQ and linden
+    const char * binding; // -bind pattern, or NULL; PIPQ derives each thread's NUMA zone from it
+};
+
+struct pq_workload_config {
+    int millis;
+    double ins_percent;
+    int prefill;
+};
+
+// runs the workload on a new queue and prints its results; returns 0 if the key sums validate
+typedef int (*pq_bench_entry)(const pq_adapter_config & config, const pq_workload_config & workload);
+
+int run_pipq_bench(const pq_adapter_config & config, const pq_workload_config & workload);
+int run_linden_bench(const pq_adapter_config & config, const pq_workload_config & workload);
+int run_lotan_bench(const pq_adapter_config & config, const pq_workload_config & workload);
+int run_smq_bench(const pq_adapter_config & config, const pq_workload_config & workload);
+
+#endif /* PQ_ADAPTER_H */
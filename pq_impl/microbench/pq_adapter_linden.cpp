@@ -0,0 +1,36 @@
+/*
+ * File:   pq_adapter_linden.cpp
+ *
+ * pqbench adapter for the Linden-Jonsson skiplist priority queue.
+ */
+
+#include "linden_impl.h"
+#include "pq_workload.h"
+
+using namespace linden_ns;
+
+#define LINDEN_MAX_LEVEL 32 // main.cpp's value
+
+class linden_adapter {
+    linden * ds;
+public:
+    linden_adapter(const pq_adapter_config & config) {
+        ds = new linden(config.max_offset, LINDEN_MAX_LEVEL, config.threads);
+        ds->pq_init();
+    }
+    ~linden_adapter() {
+        delete ds; // like main.cpp, no pq_destroy()
+    }
+    void init_thread(int tid) {}
+    bool insert(int key, long long value) { return ds->insert_linden(key, value) == 1; }
+    int delete_min() {
+        pkey_t key = 0;
+        ds->deletemin_key(&key);
+        return key;
+    }
+    long long key_sum() { return ds->debugKeySum(); }
+};
+
+int run_linden_bench(const pq_adapter_config & config, const pq_workload_config & workload) {
+    return run_workload<linden_adapter>("linden", config, workload);
+}
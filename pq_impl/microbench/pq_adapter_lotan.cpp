@@ -0,0 +1,35 @@
+/*
+ * File:   pq_adapter_lotan.cpp
+ *
+ * pqbench adapter for the Lotan-Shavit skiplist priority queue.
+ */
+
+#include "lotan_shavit_impl.h"
+#include "pq_workload.h"
+
+using namespace lotan_shavit_ns;
+
+class lotan_adapter {
+    lotan_shavit * ds;
+public:
+    lotan_adapter(const pq_adapter_config & config) {
+        ds = new lotan_shavit(config.threads, config.max_key);
+        ds->lotan_init();
+    }
+    ~lotan_adapter() {
+        delete ds;
+    }
+    void init_thread(int tid) { ds->thread_init(); }
+    bool insert(int key, long long value) { return ds->lotan_fraser_insert(key, value); }
+    int delete_min() {
+        slkey_t key = 0;
+        val_t val;
+        ds->lotan_shavit_delete_min_key(&key, &val);
+        return (int) key;
+    }
+    long long key_sum() { return ds->debugKeySum(); }
+};
+
+int run_lotan_bench(const pq_adapter_config & config, const pq_workload_config & workload) {
+    return run_workload<lotan_adapter>("lotan", config, workload);
+}
@@ -0,0 +1,38 @@
+/*
+ * File:   pq_adapter_pipq.cpp
+ *
+ * pqbench adapter for PIPQ (strict).
+ */
+
+#include "../recordmgr/debugprinting.h"
+#include "pipq_strict_impl.h"
+#include "pq_workload.h"
+
+using namespace pq_ns;
+
+#define PIPQ_LEADER_BUFFER_CAP 50 // main.cpp's defaults
+#define PIPQ_LEADER_BUFFER_IDEAL_SIZE 30
+#define PIPQ_COUNTER_TSH 10
+#define PIPQ_COUNTER_MX 20
+
+class pipq_adapter {
+    pq<long long> * ds;
+public:
+    pipq_adapter(const pq_adapter_config & config) {
+        ds = new pq<long long>(config.heap_list_size, PIPQ_LEADER_BUFFER_CAP, PIPQ_LEADER_BUFFER_IDEAL_SIZE,
+                config.threads, PIPQ_COUNTER_TSH, PIPQ_COUNTER_MX, config.max_offset);
+        ds->PQInit();
+    }
+    ~pipq_adapter() {
+        ds->PQDeinit();
+        delete ds;
+    }
+    void init_thread(int tid) { ds->threadInit(tid); }
+    bool insert(int key, long long value) { return ds->hier_insert_local(key, value); }
+    int delete_min() { return ds->hier_delete(); }
+    long long key_sum() { return ds->getKeySum(); }
+};
+
+int run_pipq_bench(const pq_adapter_config & config, const pq_workload_config & workload) {
+    return run_workload<pipq_adapter>("pipq", config, workload);
+}
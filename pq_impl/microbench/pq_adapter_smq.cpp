@@ -0,0 +1,36 @@
+/*
+ * File:   pq_adapter_smq.cpp
+ *
+ * pqbench adapter for the stealing multi-queue.
+ */
+
+#include <cstring>
+#include "smq_impl.h"
+#include "pq_workload.h"
+
+using namespace smq_ns;
+
+typedef StealingMultiQueue<std::pair<long,long>, 8, 8, true> smq_type; // main.cpp's configuration
+
+class smq_adapter {
+    smq_type * ds;
+public:
+    smq_adapter(const pq_adapter_config & config) {
+        ds = new smq_type(config.threads);
+    }
+    ~smq_adapter() {
+        delete ds;
+    }
+    void init_thread(int tid) { ds->initThread(tid); }
+    bool insert(int key, long long value) { return ds->ins_wrapper(key, value) == 1; }
+    int delete_min() {
+        long key = 0;
+        ds->del_wrapper(&key);
+        return (int) key;
+    }
+    long long key_sum() { return ds->debugKeySum(); }
+};
+
+int run_smq_bench(const pq_adapter_config & config, const pq_workload_config & workload) {
+    return run_workload<smq_adapter>("smq", config, workload);
+}
@@ -0,0 +1,156 @@
+/*
+ * File:   pq_workload.h
+ *
+ * The timed mixed workload of pqbench (main.cpp's benchmark 3 with uniform keys), templated on a queue's adapter so
+ * each pq_adapter_<ds>.cpp compiles the loop against its concrete queue. An adapter Q provides
+ *     Q(const pq_adapter_config & config)
+ *     void init_thread(int tid)             by every thread, before its first operation
+ *     bool insert(int key, long long value) false if the queue rejected the key (e.g., a duplicate)
+ *     int delete_min()                      the key removed, or a value <= 0 if the queue was empty
+ *     long long key_sum()                   sum of the keys in the queue (quiescent), for validation
+ * Every thread picks an insert with probability ins_percent and a delete-min otherwise, and the key sum of the threads
+ * is checked against the queue's at the end.
+ */
+
+#ifndef PQ_WORKLOAD_H
+#define PQ_WORKLOAD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <pthread.h>
+#include <vector>
+#include "../common/plaf.h"
+#include "../common/random.h"
+#include "../common/binding.h"
+#include "pq_adapter.h"
+
+struct bench_thread_result {
+    long long inserts;
+    long long delmins;
+    long long key_checksum; // keys inserted minus keys deleted
+    char padding[PREFETCH_SIZE_BYTES];
+};
+
+template <class Q>
+struct bench_args {
+    Q * pq;
+    int threads;
+    int max_key;
+    pq_workload_config workload;
+    pthread_barrier_t start_barrier;
+    std::atomic<bool> done;
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
+    bench_thread_result * results;
+};
+
+template <class Q>
+struct bench_thread_arg {
+    bench_args<Q> * args;
+    int tid;
+};
+
+template <class Q>
+static void * bench_thread(void * arg) {
+    bench_args<Q> * args = ((bench_thread_arg<Q> *) arg)->args;
+    int tid = ((bench_thread_arg<Q> *) arg)->tid;
+    bench_thread_result * result = &args->results[tid];
+    Q * pq = args->pq;
+    binding_bindThread(tid, LOGICAL_PROCESSORS);
+    Random rng(tid + 1);
+    pq->init_thread(tid);
+
+    for (int cnt = args->workload.prefill / args->threads; cnt > 0; ) {
+        int key = rng.nextNatural(args->max_key) + 1;
+        if (pq->insert(key, key)) {
+            result->key_checksum += key;
+            cnt--;
+        }
+    }
+    pthread_barrier_wait(&args->start_barrier);
+    if (tid == 0) {
+        args->start_time = std::chrono::high_resolution_clock::now();
+    }
+    pthread_barrier_wait(&args->start_barrier);
+
+    int cnt = 0;
+    while (!args->done) {
+        if (((++cnt) % 100) == 0 && std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - args->start_time).count() >= args->workload.millis) {
+            args->done = true;
+            break;
+        }
+        double op = rng.nextNatural(100000000) / 1000000.;
+        if (op < args->workload.ins_percent) {
+            int key = rng.nextNatural(args->max_key) + 1;
+            if (pq->insert(key, key)) {
+                result->key_checksum += key;
+            }
+            result->inserts++;
+        } else {
+            int key = pq->delete_min();
+            if (key > 0) {
+                result->key_checksum -= key;
+            }
+            result->delmins++;
+        }
+    }
+    return NULL;
+}
+
+template <class Q>
+int run_workload(const char * name, const pq_adapter_config & config, const pq_workload_config & workload) {
+    // binding.h keeps its state per translation unit: set up the copy that bench_thread and the queue read
+    if (config.binding) {
+        binding_parseCustom(config.binding);
+    }
+    binding_configurePolicy(config.threads, LOGICAL_PROCESSORS);
+
+    bench_args<Q> args;
+    args.pq = new Q(config);
+    args.threads = config.threads;
+    args.max_key = config.max_key;
+    args.workload = workload;
+    args.results = new bench_thread_result[args.threads]();
+    args.done = false;
+    pthread_barrier_init(&args.start_barrier, NULL, args.threads);
+    std::vector<pthread_t> threads(args.threads);
+    std::vector<bench_thread_arg<Q>> thread_args(args.threads);
+    for (int i = 0; i < args.threads; ++i) {
+        thread_args[i] = {&args, i};
+        if (pthread_create(&threads[i], NULL, bench_thread<Q>, &thread_args[i])) {
+            std::cout<<"ERROR: could not create thread"<<std::endl;
+            exit(-1);
+        }
+    }
+    for (int i = 0; i < args.threads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - args.start_time).count() / 1000.;
+
+    long long inserts = 0, delmins = 0, threadsKeySum = 0;
+    for (int i = 0; i < args.threads; ++i) {
+        inserts += args.results[i].inserts;
+        delmins += args.results[i].delmins;
+        threadsKeySum += args.results[i].key_checksum;
+    }
+    long long dsKeySum = args.pq->key_sum();
+    std::cout<<"data structure                : "<<name<<std::endl;
+    std::cout<<"insert throughput             : "<<(long long) (inserts / seconds)<<std::endl;
+    std::cout<<"delmin throughput             : "<<(long long) (delmins / seconds)<<std::endl;
+    std::cout<<"update throughput             : "<<(long long) ((inserts + delmins) / seconds)<<std::endl;
+    if (threadsKeySum == dsKeySum) {
+        std::cout<<"Validation OK: :) threadsKeySum = "<<threadsKeySum<<" dsKeySum="<<dsKeySum<<std::endl;
+    } else {
+        std::cout<<"Validation FAILURE: :( threadsKeySum = "<<threadsKeySum<<" dsKeySum="<<dsKeySum<<std::endl;
+    }
+
+    pthread_barrier_destroy(&args.start_barrier);
+    delete[] args.results;
+    delete args.pq;
+    return threadsKeySum == dsKeySum ? 0 : 1;
+}
+
+#endif /* PQ_WORKLOAD_H */
@@ -0,0 +1,42 @@
+/*
+ * File:   pqcheck.cpp
+ *
+ * Offline analysis of a recorded trace (microbench -record, sssp -T): checks the history against a strict
+ * priority queue (pq_lincheck.h) and reports the rank error of its delete-mins (rank_error.h).
+ *
+ * Usage: pqcheck <trace> [max violations to print]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "../common/pq_trace.h"
+#include "../common/rank_error.h"
+#include "../common/pq_lincheck.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <trace> [max violations to print]\n", argv[0]);
+        return 2;
+    }
+    pq_trace_reader trace;
+    if (!trace.open(argv[1])) {
+        return 2;
+    }
+    long long ops = 0;
+    for (int tid = 0; tid < trace.threads(); ++tid) ops += trace.count(tid);
+    printf("trace                         : %s (%d threads, %lld ops)\n", argv[1], trace.threads(), ops);
+
+    rank_error_stats rank = rank_error_analyze(trace);
+    printf("rank error mean               : %f\n", rank.rank_mean);
+    printf("rank error p50/p90/p99/max    : %lld / %lld / %lld / %lld\n", rank.rank_p50, rank.rank_p90, rank.rank_p99, rank.rank_max);
+    printf("delay mean/max                : %f / %lld\n", rank.delay_mean, rank.delay_max);
+
+    pq_lincheck_result check = pq_lincheck(trace, argc > 2 ? atoi(argv[2]) : 10);
+    if (check.ok()) {
+        printf("Validation OK: :) history is consistent with a strict priority queue (%lld delete-mins)\n", check.delete_mins);
+        return 0;
+    }
+    printf("Validation FAILURE: :( history violates strict priority queue order: %lld order, %lld empty, %lld phantom violation(s)\n",
+            check.order, check.empty, check.phantom);
+    return 1;
+}
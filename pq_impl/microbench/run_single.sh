@@ -33,6 +33,10 @@ binding_policy="0,4,8,12,16,20,24,28,32,36,40,44,48,52,56,60,64,68,72,76,80,84,8
 # (4) Microbenchmark (delete-only): num ops mixed workload
 # (5) Phased: phased workload
 # (6) Desg: designated thread workload
+# (14) Open-loop: mixed workload issued at a target rate (-rate), latency measured from each op's scheduled start
+# (15) Hold model: delete-min, then insert the popped key plus an increment (-hold <distribution> -hmean <mean>)
+# (16) PHOLD: hold model where each event is executed by a logical process (-lps) with busy work (-ework)
+# (17) Trace replay: replays a trace recorded with -record (benchmark 3) or sssp -T (-replay <file> [-replay_timing])
 
 # default values for optional parameters
 DEFAULT_TDS=96
@@ -47,6 +51,9 @@ prefill=1000000
 max_key=100000000
 duration=5000 # note: 1000 = 1 second
 
+# key distribution: uniform, zipf, ascending, descending, disjoint, clustered or duplicates
+key_dist=uniform
+
 # for mixed benchmarks (3 & 4)
 inserts=50
 deletes=50
@@ -61,13 +68,15 @@ max_offset=32
 ops_per_thread=3840000 # for benchmark 4 only; "4,100:5000000,95:1000000,50:1000000,95:1000000", "2,100:5000000,95:1000000"
 phased_workload="2,100:50000000,0:5000000" # for benchmark 5 only
 delmin_threads_per_zone=4 # for benchmark 6,8 only
+open_loop_rate=1000000 # for benchmark 14 only; aggregate ops/sec offered by all threads
+open_loop_arrival=poisson # for benchmark 14 only; poisson or fixed
 
 if [[ "$PROG" == "pipq" ]]; then
-  ./luigi.pipq.out -k $max_key -b $benchmark -p $prefill -o $ops_per_thread -dz $delmin_threads_per_zone -phased $phased_workload -h $heap_list_size -t $duration -n $threads -i $inserts -d $deletes -ct $counter_threshold -cm $counter_max -m $max_offset -bind $binding_policy
+  ./luigi.pipq.out -k $max_key -b $benchmark -p $prefill -o $ops_per_thread -dz $delmin_threads_per_zone -phased $phased_workload -h $heap_list_size -t $duration -n $threads -i $inserts -d $deletes -ct $counter_threshold -cm $counter_max -m $max_offset -dist $key_dist -rate $open_loop_rate -arrival $open_loop_arrival -bind $binding_policy
 elif [[ "$PROG" == "linden" ]]; then
-  ./luigi.linden.out -phased $phased_workload -dz $delmin_threads_per_zone -k $max_key -b $benchmark -p $prefill -t $duration -n $threads -i $inserts -d $deletes -bind $binding_policy
+  ./luigi.linden.out -phased $phased_workload -dz $delmin_threads_per_zone -k $max_key -b $benchmark -p $prefill -t $duration -n $threads -i $inserts -d $deletes -dist $key_dist -rate $open_loop_rate -arrival $open_loop_arrival -bind $binding_policy
 elif [[ "$PROG" == "lotan" ]]; then
-  ./luigi.lotan_shavit.out -k $max_key -b $benchmark -p $prefill -o $ops_per_thread -t $duration -n $threads -i $inserts -d $deletes -dz $delmin_threads_per_zone -bind $binding_policy
+  ./luigi.lotan_shavit.out -k $max_key -b $benchmark -p $prefill -o $ops_per_thread -t $duration -n $threads -i $inserts -d $deletes -dz $delmin_threads_per_zone -dist $key_dist -rate $open_loop_rate -arrival $open_loop_arrival -bind $binding_policy
 else
   echo "invalid executable passed"
 fi
@@ -9,6 +9,7 @@
 #include <set>
 #include <iostream>
 #include <optional>
+#include <vector>
 #include <numa.h>
 
 #ifndef SSSP
@@ -40,6 +41,27 @@
 
 #define SIZE_SCAN_BUF 5
 
+// per-zone worker slot states: "free"(0), "being registered"(1), "owned by a thread"(2)
+#define SLOT_FREE 0
+#define SLOT_INIT 1
+#define SLOT_TAKEN 2
+
+// idle worker adoption: every IDLE_SCAN_INTERVAL coordinate rounds the coordinator checks its zone's heaps, and
+// takes over the heap of a slot whose owner has not started an operation for IDLE_SCAN_ROUNDS consecutive scans
+#ifndef IDLE_SCAN_INTERVAL
+#define IDLE_SCAN_INTERVAL 1024
+#endif
+#define IDLE_SCAN_ROUNDS 2
+
+// worker heap compaction: every COMPACT_INTERVAL inserts an owner rebuilds its heap without cancelled elements,
+// if its heap holds at least heap size / COMPACT_RATIO tombstones
+#define COMPACT_INTERVAL 1024
+#define COMPACT_RATIO 4
+
+// checkpoint file format
+#define CHECKPOINT_MAGIC "PIPQCKP"
+#define CHECKPOINT_VERSION 1
+
 #define NODE_0 0
 #define NODE_1 1
 #define NODE_2 2
@@ -70,6 +92,14 @@ namespace pq_ns {
             V value;
         };
 
+        // filled in by the inserts for remove(): the element and the slot (zone, idx) it was inserted from
+        struct PQ_Handle {
+            int key;
+            V value;
+            int zone;
+            int idx;
+        };
+
         // the heap list
         struct __attribute__((__packed__)) HeapList {
             PQ_Node* heapList; // init to HEAP_LIST_SIZE, the size of each array
@@ -83,8 +113,15 @@ namespace pq_ns {
             int size;
             HeapList* pq_ptr; // the heap - a vector of PQ_NODE's 
             volatile long* lock;
-            char padding[(ALIGN_SIZE - (sizeof(int) + sizeof(HeapList*) + sizeof(long*)))];
+            volatile long heartbeat; // bumped by the owner on every operation
+            long last_heartbeat; // heartbeat seen by the last idle scan (coordinator only)
+            int idle_scans; // consecutive idle scans without a heartbeat change (coordinator only)
+            std::multiset<std::pair<int, V>>* tombstones; // cancelled elements still in this heap, allocated on the first cancel
+            volatile int num_tombstones; // guarded by lock, like the heap itself
+            unsigned long long adopted_into; // zone slots (bit idx) whose heap took over this heap's elements, guarded by lock
+            char padding[(ALIGN_SIZE - (3*sizeof(int) + sizeof(HeapList*) + sizeof(long*) + 2*sizeof(long) + sizeof(void*) + sizeof(long long)))];
         };
+        static_assert(NUMA_ZONE_THREADS <= 64, "PQ_Heap::adopted_into has one bit per zone slot");
 
         //sizeof 8
         struct AnnounceStruct {
@@ -94,6 +131,27 @@ namespace pq_ns {
             volatile V value; // value to insert, OR return value (if needed)
         };
 
+        /*
+            Checkpoint file: header, then the live leader elements in list order, then the array of every worker heap
+            (zone by zone, slot by slot) in heap order, heap_size[slot] elements each.
+        */
+        struct CheckpointHeader {
+            char magic[8];
+            int version;
+            int num_zones;
+            int zone_slots;
+            int node_size; // sizeof(PQ_Node), catches a different V
+            long long leader_size;
+            long long heap_size[NUMA_ZONES * NUMA_ZONE_THREADS];
+            long long repeat_keys[NUMA_ZONES * NUMA_ZONE_THREADS];
+        };
+
+        struct CheckpointLeaderEntry {
+            int key;
+            int slot; // zone * NUMA_ZONE_THREADS + idx
+            V value;
+        };
+
         struct __attribute__((__packed__)) CounterSlot {
             volatile int count;
             char padding[(ALIGN_SIZE - (sizeof(volatile int)))];
@@ -150,12 +208,28 @@ namespace pq_ns {
         inline static thread_local volatile long* t_compete_coord_lock;
         inline static thread_local bool* t_exit;
         inline static thread_local LeaderLargest* t_largest_in_leader;
+        inline static thread_local int t_coord_rounds;
+        inline static thread_local int t_compact_cnt;
 
         /*
             Copy per NUMA zone (but all are identical) to minimize cross-NUMA traffic during helping
         */
         int *thread_mappings_0, *thread_mappings_1, *thread_mappings_2, *thread_mappings_3;
 
+        /*
+            Slot ownership per NUMA zone (NUMA_ZONE_THREADS slots each). Threads set up by PQInit own the
+            first slots; register_thread() claims any free one. A released slot keeps its heap (and leader entries)
+            for the next thread that claims it.
+        */
+        volatile int *slot_status_0, *slot_status_1, *slot_status_2, *slot_status_3;
+
+        /*
+            Set once the slot's heap and announce entry are initialised, and never cleared (a released slot keeps its
+            heap). counter_N only bounds the scans: a thread may raise it past a lower slot that a concurrent
+            register_thread() has claimed but not set up yet, so the scans skip slots that are not ready.
+        */
+        volatile int *slot_ready_0, *slot_ready_1, *slot_ready_2, *slot_ready_3;
+
         LeaderLargest *largest_in_leader_0, *largest_in_leader_1, *largest_in_leader_2, *largest_in_leader_3;
 
         bool *active_numa_zones_0;
@@ -315,6 +389,26 @@ namespace pq_ns {
             }
         }
 
+        volatile int* get_slot_status(int group) {
+            switch(group) {
+                case NODE_0: return slot_status_0; break;
+                case NODE_1: return slot_status_1; break;
+                case NODE_2: return slot_status_2; break;
+                case NODE_3: return slot_status_3; break;
+                default: COUTATOMIC("SHOULD NOT BE HERE (get_slot_status())\n"); exit(0); break;
+            }
+        }
+
+        volatile int* get_slot_ready(int group) {
+            switch(group) {
+                case NODE_0: return slot_ready_0; break;
+                case NODE_1: return slot_ready_1; break;
+                case NODE_2: return slot_ready_2; break;
+                case NODE_3: return slot_ready_3; break;
+                default: COUTATOMIC("SHOULD NOT BE HERE (get_slot_ready())\n"); exit(0); break;
+            }
+        }
+
         bool check_active_zone(int curr_group, int check_group) {
             switch(curr_group) {
                 case 0: return active_numa_zones_0[check_group]; break;
@@ -335,48 +429,62 @@ namespace pq_ns {
             }
         }
 
+        // counter_N[group] is the number of slots ever handed out in group (coordinators scan up to it), so it only grows
+        void raise_numa_workers(int group, int cnt) {
+            int* counters[NUMA_ZONES] = {counter_0, counter_1, counter_2, counter_3};
+            for (int i = 0; i < NUMA_ZONES; i++) {
+                int cur = counters[i][group];
+                while (cur < cnt && !__sync_bool_compare_and_swap(&(counters[i][group]), cur, cnt)) {
+                    cur = counters[i][group];
+                }
+            }
+            if (!active_numa_zones_0[group]) {
+                active_numa_zones_0[group] = true;
+                active_numa_zones_1[group] = true;
+                active_numa_zones_2[group] = true;
+                active_numa_zones_3[group] = true;
+            }
+        }
+
         void clearCounters() {
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-                switch(group) {
-                    case 0:
-                        num_moves_0[idx].count = 0;
-                        num_ins_0[idx].count = 0;
-                        num_fastpath_0[idx].count = 0;
-                        break;
-                    case 1:
-                        num_moves_1[idx].count = 0;
-                        num_ins_1[idx].count = 0;
-                        num_fastpath_1[idx].count = 0;
-                        break;
-                    case 2:
-                        num_moves_2[idx].count = 0;
-                        num_ins_2[idx].count = 0;
-                        num_fastpath_2[idx].count = 0;
-                        break;
-                    case 3:
-                        num_moves_3[idx].count = 0;
-                        num_ins_3[idx].count = 0;
-                        num_fastpath_3[idx].count = 0;
-                        break;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    switch(group) {
+                        case 0:
+                            num_moves_0[idx].count = 0;
+                            num_ins_0[idx].count = 0;
+                            num_fastpath_0[idx].count = 0;
+                            break;
+                        case 1:
+                            num_moves_1[idx].count = 0;
+                            num_ins_1[idx].count = 0;
+                            num_fastpath_1[idx].count = 0;
+                            break;
+                        case 2:
+                            num_moves_2[idx].count = 0;
+                            num_ins_2[idx].count = 0;
+                            num_fastpath_2[idx].count = 0;
+                            break;
+                        case 3:
+                            num_moves_3[idx].count = 0;
+                            num_ins_3[idx].count = 0;
+                            num_fastpath_3[idx].count = 0;
+                            break;
+                    }
                 }
             }
         }
 
         long getTotalMoves() {
             long sum = 0;
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-
-                switch(group) {
-                    case 0: sum += num_moves_0[idx].count; break;
-                    case 1: sum += num_moves_1[idx].count; break;
-                    case 2: sum += num_moves_2[idx].count; break;
-                    case 3: sum += num_moves_3[idx].count; break;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    switch(group) {
+                        case 0: sum += num_moves_0[idx].count; break;
+                        case 1: sum += num_moves_1[idx].count; break;
+                        case 2: sum += num_moves_2[idx].count; break;
+                        case 3: sum += num_moves_3[idx].count; break;
+                    }
                 }
             }
             return sum;
@@ -384,16 +492,14 @@ namespace pq_ns {
 
         long getTotalFastPath() {
             long sum = 0;
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-
-                switch(group) {
-                    case 0: sum += num_fastpath_0[idx].count; break;
-                    case 1: sum += num_fastpath_1[idx].count; break;
-                    case 2: sum += num_fastpath_2[idx].count; break;
-                    case 3: sum += num_fastpath_3[idx].count; break;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    switch(group) {
+                        case 0: sum += num_fastpath_0[idx].count; break;
+                        case 1: sum += num_fastpath_1[idx].count; break;
+                        case 2: sum += num_fastpath_2[idx].count; break;
+                        case 3: sum += num_fastpath_3[idx].count; break;
+                    }
                 }
             }
             return sum;
@@ -401,16 +507,14 @@ namespace pq_ns {
 
         long getTotalInsertUp() {
             long sum = 0;
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-
-                switch(group) {
-                    case 0: sum += num_ins_0[idx].count; break;
-                    case 1: sum += num_ins_1[idx].count; break;
-                    case 2: sum += num_ins_2[idx].count; break;
-                    case 3: sum += num_ins_3[idx].count; break;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    switch(group) {
+                        case 0: sum += num_ins_0[idx].count; break;
+                        case 1: sum += num_ins_1[idx].count; break;
+                        case 2: sum += num_ins_2[idx].count; break;
+                        case 3: sum += num_ins_3[idx].count; break;
+                    }
                 }
             }
             return sum;
@@ -421,17 +525,14 @@ namespace pq_ns {
 
             size += set_size(leader_set);
             long long leader_size = size;
-            // // get sizes from thread-local heaps
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-             #ifdef SSSP
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-             #else
-                int cpu_id = customBinding[i];
-             #endif
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-                PQ_Heap* heap = get_heap_mapping(idx, group);
-                size += heap->size;
+            // get sizes from worker heaps (including heaps of released slots, which still hold elements)
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    PQ_Heap* heap = get_heap_mapping(idx, group);
+                    if (heap) {
+                        size += heap->size;
+                    }
+                }
             }
             long long worker_size = size - leader_size;
 
@@ -447,54 +548,41 @@ namespace pq_ns {
             int num_incorrect = 0;
             int cnt = 1;
 
-            // COUTATOMIC("Counter values:\n");
-            // // print counter values for reference
-            // for (int i = 0; i < TOTAL_THREADS; i++) {
-            //     int cpu_id = i/24 + 4*(i % 24);
-            //     int group = get_group(cpu_id);
-            //     int idx = get_thread_mapping(group, i);
-            //     CounterSlot* slot = get_counters(group, idx);
-            //     COUTATOMIC("tid=" << i << ": " << slot->count << "\n");
-            // }
-            // COUTATOMIC("\n");
-
-            int* largest_leader = new int[96];
+            int* largest_leader = new int[NUMA_ZONES * NUMA_ZONE_THREADS];
             
-            num_incorrect += set_validate(leader_set, largest_leader);
+            num_incorrect += set_validate(leader_set, largest_leader, NUMA_ZONE_THREADS);
             if (num_incorrect) {
                 invalid = true;
             }
 
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-             #ifdef SSSP
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-             #else
-                int cpu_id = customBinding[i];
-             #endif
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-                PQ_Heap* worker = get_heap_mapping(idx, group);
-                LeaderLargest* last_ptr = get_last_ptr(idx, group);
-
-                last_key = largest_leader[group * 24 + idx];
-                assert(last_key == last_ptr->largest_ptr->key);
-                COUTATOMIC("\n[tid=" << i << "]\nlast_key (from leader): " << last_key << "\n");
-                COUTATOMIC("largest_key_ptr = " << last_ptr->largest_ptr->key << "\n");
-
-                //! only comparing the largest in leader to smallest from worker
-                int first = 0; //!
-                while (first == 0) { //!
-                //while (worker->size > 0) {
-                    int min;
-                    std::optional<V> up_val = delete_min_worker(worker, &min);
-                    if (last_key > min && min != EMPTY) {
-                        COUTATOMIC("(cnt=" << cnt << ") ORDER INCORRECT!!! " << last_key << " -> " << min << "\n");
-                        invalid = true;
-                        num_incorrect++;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    PQ_Heap* worker = get_heap_mapping(idx, group);
+                    LeaderLargest* last_ptr = get_last_ptr(idx, group);
+                    if (!worker || !last_ptr->largest_ptr) {
+                        continue;
+                    }
+
+                    last_key = largest_leader[group * NUMA_ZONE_THREADS + idx];
+                    assert(last_key == last_ptr->largest_ptr->key);
+                    COUTATOMIC("\n[zone=" << group << ", idx=" << idx << "]\nlast_key (from leader): " << last_key << "\n");
+                    COUTATOMIC("largest_key_ptr = " << last_ptr->largest_ptr->key << "\n");
+
+                    //! only comparing the largest in leader to smallest from worker
+                    int first = 0; //!
+                    while (first == 0) { //!
+                    //while (worker->size > 0) {
+                        int min;
+                        std::optional<V> up_val = delete_min_worker(worker, &min);
+                        if (last_key > min && min != EMPTY) {
+                            COUTATOMIC("(cnt=" << cnt << ") ORDER INCORRECT!!! " << last_key << " -> " << min << "\n");
+                            invalid = true;
+                            num_incorrect++;
+                        }
+                        last_key = min;
+                        cnt++;
+                        first++; //!
                     }
-                    last_key = min;
-                    cnt++;
-                    first++; //!
                 }
             }
             delete[] largest_leader;
@@ -517,32 +605,30 @@ namespace pq_ns {
             COUTATOMIC("leader sum is: " << leader_sum << endl);
             
             COUTATOMIC(endl << "calculating worker..." << endl);
-            for (int i = 0; i < TOTAL_THREADS; i++) {
-             #ifdef SSSP
-                int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-             #else
-                int cpu_id = customBinding[i];
-             #endif
-                int group = get_group(cpu_id);
-                int idx = get_thread_mapping(group, i);
-                PQ_Heap* heap = get_heap_mapping(idx, group);
-                HeapList* list = heap->pq_ptr;
-
-                int cnt = 1;
-                for (int j = 0; j < heap->size; j++) {
-                    if (j >= cnt * HEAP_LIST_SIZE) {
-                        list = list->next;
-                        cnt++;
+            for (int group = 0; group < NUMA_ZONES; group++) {
+                for (int idx = 0; idx < get_numa_workers(NODE_0, group); idx++) {
+                    PQ_Heap* heap = get_heap_mapping(idx, group);
+                    if (!heap) {
+                        continue;
+                    }
+                    HeapList* list = heap->pq_ptr;
+
+                    int cnt = 1;
+                    for (int j = 0; j < heap->size; j++) {
+                        if (j >= cnt * HEAP_LIST_SIZE) {
+                            list = list->next;
+                            cnt++;
+                        }
+                        int idx = j % HEAP_LIST_SIZE;
+                        sum += (list->heapList[idx]).key;
                     }
-                    int idx = j % HEAP_LIST_SIZE;
-                    sum += (list->heapList[idx]).key;
                 }
             }
             long long worker_sum = sum - leader_sum;
             COUTATOMIC("worker sum is: " << worker_sum << endl << endl);
 
             long long tot_repeats = 0;
-            for (int i = 0; i < TOTAL_THREADS; i++) { 
+            for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) { 
                 tot_repeats += repeat_keys[i];
             }
             if (tot_repeats > 0) {
@@ -627,18 +713,34 @@ namespace pq_ns {
         
         void PQInit(); // initializes thread local heaps, active NUMA zones
         void threadInit(int tid); // initializes: t_tid, t_idx and t_group
+        void bindThreadSlot(int group, int idx); // points the thread-local shortcuts at slot idx of zone group
         void HeapInit(PQ_Heap **Heap, int group, int heap_size); // called by PQInit to initialize t-local heap
         void Announce_allocation(AnnounceStruct **announce, int size, int group);
         
         void PQDeinit();
         void HeapDeinit(PQ_Heap **Heap);
 
+        // elastic membership: threads outside the TOTAL_THREADS set up by PQInit can join and leave at any time
+        int register_thread(int cpu_id=-1); // claims a free slot in the zone of cpu_id (default: current cpu); returns zone*NUMA_ZONE_THREADS + idx, or -1 if the zone is full
+        void unregister_thread(); // hands the worker heap to a zone peer (if any) and releases the slot
+        void adopt_worker_heap(PQ_Heap *from, int peer_idx, int group); // moves every element of from into slot peer_idx of group (leader or heap)
+
         // helpers for worker heap methods
         bool getChildList(HeapList** heapList, int* count, int* c_idx, int size, int heapSize);
         bool getParentList(HeapList** heapList, int* count, int* p_idx, int heapSize);
+        void getHeapChunks(PQ_Heap *Heap, std::vector<HeapList*>& chunks, int num_elements, int group); // allocates missing chunks
+        void heapify_worker(PQ_Heap *Heap, std::vector<HeapList*>& chunks);
+
+        // meld: moves every element of other into this pq (quiescent - no operations on either pq while it runs)
+        void meld(pq& other);
+        void meld_worker(PQ_Heap *dest, PQ_Heap *src, int src_list_size, int group);
+        void place_rejected(std::vector<node__t*>& rejected, node__t* largest[], int count[]); // elements set_merge() rejected
+        void clear(); // empties the pq for reuse (quiescent), keeping the worker heaps' memory
         
         // insert methods
-        bool hier_insert_local(int key, V value);
+        bool hier_insert_local(int key, V value, PQ_Handle* handle = NULL); // handle (if given) is for remove()
+        int hier_insert_batch(const PQ_Node* elems, int n, PQ_Handle* handles = NULL); // one lock for n inserts, returns how many were inserted
+        bool insert_locked(int key, V value);
         void insert_worker(PQ_Heap *Heap, int K, V value);
 
         // delete-min methods
@@ -647,8 +749,27 @@ namespace pq_ns {
         void try_compete_coordinator();
         void try_become_coordinator();
         void Coordinate();
+        void scan_idle_workers();
         void delete_min_leader(int idx);
         std::optional<V> delete_min_worker(PQ_Heap *Heap, int* key);
+        std::optional<V> pop_min_worker(PQ_Heap *Heap, int* key);
+
+        /*
+            Cancellation (e.g., timers): the inserts hand out a handle naming the element's (key, value) and its slot,
+            and values must be unique among elements in the pq (e.g., a timer id). remove() first looks in the slot's heap
+            under that heap's lock alone, tombstoning the element there (its delete-mins and compaction consume it). Only
+            if it is not there does it take coord_lock, to unlink it from the leader or follow it to a peer's heap.
+        */
+        bool remove(PQ_Handle handle); // false if the element is not in the pq (e.g., already returned by a delete-min)
+        bool cancel_in_heap(PQ_Heap *Heap, int key, V value);
+        bool consume_tombstone(PQ_Heap *Heap, int key, V value);
+        void compact_worker(PQ_Heap *Heap);
+        void upsert_worker(int idx, int zone);
+
+        // checkpoint / restore (quiescent): restore needs an empty pq with the same NUMA_ZONES x NUMA_ZONE_THREADS layout,
+        // HEAP_LIST_SIZE may differ. Both return false (with a message) on failure.
+        bool checkpoint(const char* path);
+        bool restore(const char* path);
 
         // used by both insert and delete-min to help upsert elements to leader when needed
         void help_upsert();
@@ -1,7 +1,16 @@
+#include <algorithm>
 #include <barrier>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
 #include "pipq_strict.h"
+#include "../harris_ll/harris_merge.h"
 #include "../recordmgr/debugprinting.h"
 #ifndef SSSP
 #include "../common/binding.h"
@@ -106,6 +115,12 @@ void pq_ns::pq<V>::PQInit() {
                 break;
         }
     }
+    // every per-zone array below has NUMA_ZONE_THREADS slots
+    if (cnt0 > NUMA_ZONE_THREADS || cnt1 > NUMA_ZONE_THREADS || cnt2 > NUMA_ZONE_THREADS || cnt3 > NUMA_ZONE_THREADS) {
+        cerr << "Error: " << cnt0 << "/" << cnt1 << "/" << cnt2 << "/" << cnt3 << " threads mapped to NUMA zones 0-3, but a zone has only "
+             << NUMA_ZONE_THREADS << " worker slots (NUMA_ZONE_THREADS)." << endl;
+        exit(1);
+    }
     // stored to retrieve, numa-locally, the number of workers in each socket
     counter_0[NODE_0] = cnt0;
     counter_1[NODE_0] = cnt0;
@@ -127,74 +142,104 @@ void pq_ns::pq<V>::PQInit() {
     counter_2[NODE_3] = cnt3;
     counter_3[NODE_3] = cnt3;
 
-    num_moves_0 = (DebugCounterSlot*)numa_alloc_onnode(cnt0 * sizeof(DebugCounterSlot), NODE_0);
-    num_moves_1 = (DebugCounterSlot*)numa_alloc_onnode(cnt1 * sizeof(DebugCounterSlot), NODE_1);
-    num_moves_2 = (DebugCounterSlot*)numa_alloc_onnode(cnt2 * sizeof(DebugCounterSlot), NODE_2);
-    num_moves_3 = (DebugCounterSlot*)numa_alloc_onnode(cnt3 * sizeof(DebugCounterSlot), NODE_3);
-
-    num_fastpath_0 = (DebugCounterSlot*)numa_alloc_onnode(cnt0 * sizeof(DebugCounterSlot), NODE_0);
-    num_fastpath_1 = (DebugCounterSlot*)numa_alloc_onnode(cnt1 * sizeof(DebugCounterSlot), NODE_1);
-    num_fastpath_2 = (DebugCounterSlot*)numa_alloc_onnode(cnt2 * sizeof(DebugCounterSlot), NODE_2);
-    num_fastpath_3 = (DebugCounterSlot*)numa_alloc_onnode(cnt3 * sizeof(DebugCounterSlot), NODE_3);
-
-    num_ins_0 = (DebugCounterSlot*)numa_alloc_onnode(cnt0 * sizeof(DebugCounterSlot), NODE_0);
-    num_ins_1 = (DebugCounterSlot*)numa_alloc_onnode(cnt1 * sizeof(DebugCounterSlot), NODE_1);
-    num_ins_2 = (DebugCounterSlot*)numa_alloc_onnode(cnt2 * sizeof(DebugCounterSlot), NODE_2);
-    num_ins_3 = (DebugCounterSlot*)numa_alloc_onnode(cnt3 * sizeof(DebugCounterSlot), NODE_3);
-
-    // initializing worker heaps, one per NUMA zone (array containing one heap per thread)
-    heap_0 = (PQ_Heap**)numa_alloc_onnode(cnt0 * sizeof(PQ_Heap*), NODE_0);
-    heap_1 = (PQ_Heap**)numa_alloc_onnode(cnt1 * sizeof(PQ_Heap*), NODE_1);
-    heap_2 = (PQ_Heap**)numa_alloc_onnode(cnt2 * sizeof(PQ_Heap*), NODE_2);
-    heap_3 = (PQ_Heap**)numa_alloc_onnode(cnt3 * sizeof(PQ_Heap*), NODE_3);
+    num_moves_0 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_0);
+    num_moves_1 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_1);
+    num_moves_2 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_2);
+    num_moves_3 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_3);
+
+    num_fastpath_0 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_0);
+    num_fastpath_1 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_1);
+    num_fastpath_2 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_2);
+    num_fastpath_3 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_3);
+
+    num_ins_0 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_0);
+    num_ins_1 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_1);
+    num_ins_2 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_2);
+    num_ins_3 = (DebugCounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DebugCounterSlot), NODE_3);
+
+    // initializing worker heaps, one per NUMA zone (array containing one heap per slot)
+    // slots beyond the initial threads get their heap when a thread first registers into them
+    heap_0 = (PQ_Heap**)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(PQ_Heap*), NODE_0);
+    heap_1 = (PQ_Heap**)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(PQ_Heap*), NODE_1);
+    heap_2 = (PQ_Heap**)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(PQ_Heap*), NODE_2);
+    heap_3 = (PQ_Heap**)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(PQ_Heap*), NODE_3);
+    slot_status_0 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_0);
+    slot_status_1 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_1);
+    slot_status_2 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_2);
+    slot_status_3 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_3);
+    slot_ready_0 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_0);
+    slot_ready_1 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_1);
+    slot_ready_2 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_2);
+    slot_ready_3 = (volatile int*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(volatile int), NODE_3);
+    for (int i = 0; i < NUMA_ZONE_THREADS; i++) {
+        heap_0[i] = NULL;
+        heap_1[i] = NULL;
+        heap_2[i] = NULL;
+        heap_3[i] = NULL;
+        slot_status_0[i] = SLOT_FREE;
+        slot_status_1[i] = SLOT_FREE;
+        slot_status_2[i] = SLOT_FREE;
+        slot_status_3[i] = SLOT_FREE;
+        slot_ready_0[i] = false;
+        slot_ready_1[i] = false;
+        slot_ready_2[i] = false;
+        slot_ready_3[i] = false;
+    }
     for (int i = 0; i < cnt0; i++) {
         HeapInit(&(heap_0[i]), NODE_0, HEAP_LIST_SIZE);
+        slot_status_0[i] = SLOT_TAKEN;
+        slot_ready_0[i] = true;
     }
     for (int i = 0; i < cnt1; i++) {
         HeapInit(&(heap_1[i]), NODE_1, HEAP_LIST_SIZE);
+        slot_status_1[i] = SLOT_TAKEN;
+        slot_ready_1[i] = true;
     }
     for (int i = 0; i < cnt2; i++) {
         HeapInit(&(heap_2[i]), NODE_2, HEAP_LIST_SIZE);
+        slot_status_2[i] = SLOT_TAKEN;
+        slot_ready_2[i] = true;
     }
     for (int i = 0; i < cnt3; i++) {
         HeapInit(&(heap_3[i]), NODE_3, HEAP_LIST_SIZE);
+        slot_status_3[i] = SLOT_TAKEN;
+        slot_ready_3[i] = true;
     }
 
     // initialize the leader structure (calls method defined in harris.h)
     leader_set = set_new(MAX_OFFSET);
 
-    int total_cnt = cnt0 + cnt1 + cnt2 + cnt3;
-    lead_counters_0 = (CounterSlot*)numa_alloc_onnode(cnt0 * sizeof(CounterSlot), NODE_0);
-    lead_counters_1 = (CounterSlot*)numa_alloc_onnode(cnt1 * sizeof(CounterSlot), NODE_1);
-    lead_counters_2 = (CounterSlot*)numa_alloc_onnode(cnt2 * sizeof(CounterSlot), NODE_2);
-    lead_counters_3 = (CounterSlot*)numa_alloc_onnode(cnt3 * sizeof(CounterSlot), NODE_3);
+    lead_counters_0 = (CounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(CounterSlot), NODE_0);
+    lead_counters_1 = (CounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(CounterSlot), NODE_1);
+    lead_counters_2 = (CounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(CounterSlot), NODE_2);
+    lead_counters_3 = (CounterSlot*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(CounterSlot), NODE_3);
 
-    largest_in_leader_0 = (LeaderLargest*)numa_alloc_onnode(cnt0 * sizeof(LeaderLargest), NODE_0);
-    largest_in_leader_1 = (LeaderLargest*)numa_alloc_onnode(cnt1 * sizeof(LeaderLargest), NODE_1);
-    largest_in_leader_2 = (LeaderLargest*)numa_alloc_onnode(cnt2 * sizeof(LeaderLargest), NODE_2);
-    largest_in_leader_3 = (LeaderLargest*)numa_alloc_onnode(cnt3 * sizeof(LeaderLargest), NODE_3);
+    largest_in_leader_0 = (LeaderLargest*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(LeaderLargest), NODE_0);
+    largest_in_leader_1 = (LeaderLargest*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(LeaderLargest), NODE_1);
+    largest_in_leader_2 = (LeaderLargest*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(LeaderLargest), NODE_2);
+    largest_in_leader_3 = (LeaderLargest*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(LeaderLargest), NODE_3);
 
     // init leader counters and max ptrs
-    for (int i = 0; i < cnt0; i++) {
+    for (int i = 0; i < NUMA_ZONE_THREADS; i++) {
         lead_counters_0[i].count = 0;
         largest_in_leader_0[i].largest_ptr = NULL;
     }
-    for (int i = 0; i < cnt1; i++) {
+    for (int i = 0; i < NUMA_ZONE_THREADS; i++) {
         lead_counters_1[i].count = 0;
         largest_in_leader_1[i].largest_ptr = NULL;
     }
-    for (int i = 0; i < cnt2; i++) {
+    for (int i = 0; i < NUMA_ZONE_THREADS; i++) {
         lead_counters_2[i].count = 0;
         largest_in_leader_2[i].largest_ptr = NULL;
     }
-    for (int i = 0; i < cnt3; i++) {
+    for (int i = 0; i < NUMA_ZONE_THREADS; i++) {
         lead_counters_3[i].count = 0;
         largest_in_leader_3[i].largest_ptr = NULL;
     }
     
-    // used to correct key-sum in case duplicates are encountered at the leader level
-    repeat_keys = (volatile long long*)numa_alloc_onnode(total_cnt * sizeof(volatile long long), NODE_0);
-    for (int i = 0; i < total_cnt; i++) {
+    // used to correct key-sum in case duplicates are encountered at the leader level (indexed zone*NUMA_ZONE_THREADS + idx)
+    repeat_keys = (volatile long long*)numa_alloc_onnode(NUMA_ZONES * NUMA_ZONE_THREADS * sizeof(volatile long long), NODE_0);
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
         repeat_keys[i] = 0;
     }
 
@@ -211,15 +256,15 @@ void pq_ns::pq<V>::PQInit() {
     *compete_coord_2 = 0;
     *compete_coord_3 = 0;
 
-    Announce_allocation(&announce_coord_0, cnt0, NODE_0); // "announce_coord_0" : for coordinator when deleting
-    Announce_allocation(&announce_coord_1, cnt1, NODE_1);
-    Announce_allocation(&announce_coord_2, cnt2, NODE_2);
-    Announce_allocation(&announce_coord_3, cnt3, NODE_3);
+    Announce_allocation(&announce_coord_0, NUMA_ZONE_THREADS, NODE_0); // "announce_coord_0" : for coordinator when deleting
+    Announce_allocation(&announce_coord_1, NUMA_ZONE_THREADS, NODE_1);
+    Announce_allocation(&announce_coord_2, NUMA_ZONE_THREADS, NODE_2);
+    Announce_allocation(&announce_coord_3, NUMA_ZONE_THREADS, NODE_3);
 
-    delmin_cntr_0 = (DelMinCntr*)numa_alloc_onnode(cnt0 * sizeof(DelMinCntr), NODE_0);
-    delmin_cntr_1 = (DelMinCntr*)numa_alloc_onnode(cnt1 * sizeof(DelMinCntr), NODE_1);
-    delmin_cntr_2 = (DelMinCntr*)numa_alloc_onnode(cnt2 * sizeof(DelMinCntr), NODE_2);
-    delmin_cntr_3 = (DelMinCntr*)numa_alloc_onnode(cnt3 * sizeof(DelMinCntr), NODE_3);
+    delmin_cntr_0 = (DelMinCntr*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DelMinCntr), NODE_0);
+    delmin_cntr_1 = (DelMinCntr*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DelMinCntr), NODE_1);
+    delmin_cntr_2 = (DelMinCntr*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DelMinCntr), NODE_2);
+    delmin_cntr_3 = (DelMinCntr*)numa_alloc_onnode(NUMA_ZONE_THREADS * sizeof(DelMinCntr), NODE_3);
 
     COUTATOMIC("Done, moving on to thread inits\n");
 }
@@ -235,76 +280,85 @@ void pq_ns::pq<V>::threadInit(int tid) {
     t_group = get_group(cpu_id);
     t_tid = tid;
     t_idx = get_thread_mapping(t_group, tid);
-    t_local_heap = get_heap_mapping(t_idx, t_group);
     COUTATOMIC("INITIALIZING THREAD (tid, idx): (" << t_tid << ", " << t_idx << ")\tcpu_id = " << cpu_id << "\tCPUID: " << sched_getcpu() << ", zone: " << t_group <<  "\n");
 
-    switch(t_group) {
+    bindThreadSlot(t_group, t_idx);
+    pthread_barrier_wait(&WaitForAll);
+}
+
+// set the thread local shortcuts for slot idx of zone group (shared by threadInit and register_thread)
+template <class V>
+void pq_ns::pq<V>::bindThreadSlot(int group, int idx) {
+    t_group = group;
+    t_idx = idx;
+    t_local_heap = get_heap_mapping(idx, group);
+
+    switch(group) {
         case NODE_0:
             announce_coord = announce_coord_0;
-            t_num_workers = counter_0[t_group];
+            t_num_workers = counter_0[group];
             t_compete_coord_lock = compete_coord_0;
-            t_lead_counters = &(lead_counters_0[t_idx]);
-            t_largest_in_leader = &(largest_in_leader_0[t_idx]);
+            t_lead_counters = &(lead_counters_0[idx]);
+            t_largest_in_leader = &(largest_in_leader_0[idx]);
             t_delmin_cntr = delmin_cntr_0;
 
             // counters
-            t_num_moves = &(num_moves_0[t_idx]);
-            num_moves_0[t_idx].count = 0;
-            t_num_ins = &(num_ins_0[t_idx]);
-            num_ins_0[t_idx].count = 0;
-            t_num_fastpath = &(num_fastpath_0[t_idx]);
-            num_fastpath_0[t_idx].count = 0;
+            t_num_moves = &(num_moves_0[idx]);
+            num_moves_0[idx].count = 0;
+            t_num_ins = &(num_ins_0[idx]);
+            num_ins_0[idx].count = 0;
+            t_num_fastpath = &(num_fastpath_0[idx]);
+            num_fastpath_0[idx].count = 0;
             break;
         case NODE_1:
             announce_coord = announce_coord_1;
-            t_num_workers = counter_1[t_group];
+            t_num_workers = counter_1[group];
             t_compete_coord_lock = compete_coord_1;
-            t_lead_counters = &(lead_counters_1[t_idx]);
-            t_largest_in_leader = &(largest_in_leader_1[t_idx]);
+            t_lead_counters = &(lead_counters_1[idx]);
+            t_largest_in_leader = &(largest_in_leader_1[idx]);
             t_delmin_cntr = delmin_cntr_1;
 
             // counters
-            t_num_moves = &(num_moves_1[t_idx]);
-            num_moves_1[t_idx].count = 0;
-            t_num_ins = &(num_ins_1[t_idx]);
-            num_ins_1[t_idx].count = 0;
-            t_num_fastpath = &(num_fastpath_1[t_idx]);
-            num_fastpath_1[t_idx].count = 0;
+            t_num_moves = &(num_moves_1[idx]);
+            num_moves_1[idx].count = 0;
+            t_num_ins = &(num_ins_1[idx]);
+            num_ins_1[idx].count = 0;
+            t_num_fastpath = &(num_fastpath_1[idx]);
+            num_fastpath_1[idx].count = 0;
             break;
         case NODE_2:
             announce_coord = announce_coord_2;
-            t_num_workers = counter_2[t_group];
+            t_num_workers = counter_2[group];
             t_compete_coord_lock = compete_coord_2;
-            t_lead_counters = &(lead_counters_2[t_idx]);
-            t_largest_in_leader = &(largest_in_leader_2[t_idx]);
+            t_lead_counters = &(lead_counters_2[idx]);
+            t_largest_in_leader = &(largest_in_leader_2[idx]);
             t_delmin_cntr = delmin_cntr_2;
 
             // counters
-            t_num_moves = &(num_moves_2[t_idx]);
-            num_moves_2[t_idx].count = 0;
-            t_num_ins = &(num_ins_2[t_idx]);
-            num_ins_2[t_idx].count = 0;
-            t_num_fastpath = &(num_fastpath_2[t_idx]);
-            num_fastpath_2[t_idx].count = 0;
+            t_num_moves = &(num_moves_2[idx]);
+            num_moves_2[idx].count = 0;
+            t_num_ins = &(num_ins_2[idx]);
+            num_ins_2[idx].count = 0;
+            t_num_fastpath = &(num_fastpath_2[idx]);
+            num_fastpath_2[idx].count = 0;
             break;
         case NODE_3:
             announce_coord = announce_coord_3;
-            t_num_workers = counter_3[t_group];
+            t_num_workers = counter_3[group];
             t_compete_coord_lock = compete_coord_3;
-            t_lead_counters = &(lead_counters_3[t_idx]);
-            t_largest_in_leader = &(largest_in_leader_3[t_idx]);
+            t_lead_counters = &(lead_counters_3[idx]);
+            t_largest_in_leader = &(largest_in_leader_3[idx]);
             t_delmin_cntr = delmin_cntr_3;
 
             // counters
-            t_num_moves = &(num_moves_3[t_idx]);
-            num_moves_3[t_idx].count = 0;
-            t_num_ins = &(num_ins_3[t_idx]);
-            num_ins_3[t_idx].count = 0;
-            t_num_fastpath = &(num_fastpath_3[t_idx]);
-            num_fastpath_3[t_idx].count = 0;
+            t_num_moves = &(num_moves_3[idx]);
+            num_moves_3[idx].count = 0;
+            t_num_ins = &(num_ins_3[idx]);
+            num_ins_3[idx].count = 0;
+            t_num_fastpath = &(num_fastpath_3[idx]);
+            num_fastpath_3[idx].count = 0;
             break;
     }
-    pthread_barrier_wait(&WaitForAll);
 }
 
 template <class V>
@@ -317,6 +371,12 @@ void pq_ns::pq<V>::HeapInit(PQ_Heap** heap, int group, int heap_size) {
     (*heap)->lock   = (long*)numa_alloc_onnode(sizeof(long), group);
     *((*heap)->lock) = 0;
     (*heap)->size   = ROOT; // ROOT = 0
+    (*heap)->heartbeat = 0;
+    (*heap)->last_heartbeat = 0;
+    (*heap)->idle_scans = 0;
+    (*heap)->tombstones = nullptr;
+    (*heap)->num_tombstones = 0;
+    (*heap)->adopted_into = 0;
 }
 
 template <class V>
@@ -342,39 +402,42 @@ void pq_ns::pq<V>::PQDeinit() {
     COUTATOMIC("\n\n[[ VALIDATING ORDERING COMMENTED OUT ]]\n");
     COUTATOMIC("Done.\nNow de-init.\n");
 
-    // de-init heap members & mappings
-    for (int i = 0; i < TOTAL_THREADS; i++) {
-     #ifdef SSSP
-        int cpu_id = i/24 + 4*(i % 24); // !NOTE: assumes threads are binded w no hyperthreading, numa zone by numa zone (0 -> 3)
-     #else
-        int cpu_id = customBinding[i];
-     #endif
-        int group = get_group(cpu_id);
-        int idx = get_thread_mapping(group, i);
-        PQ_Heap* heap = get_heap_mapping(idx, group);
-        
-        // deinit thread-local heap
-        HeapDeinit(&heap);
+    // de-init heap members (every slot that ever had a heap, whether or not a thread still owns it)
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            if (heap) {
+                HeapDeinit(&heap);
+            }
+        }
     }
     // de-init the actual NUMA-local heaps
-    numa_free(heap_0, counter_0[NODE_0] * sizeof(PQ_Heap));
-    numa_free(heap_1, counter_0[NODE_1] * sizeof(PQ_Heap));
-    numa_free(heap_2, counter_0[NODE_2] * sizeof(PQ_Heap));
-    numa_free(heap_3, counter_0[NODE_3] * sizeof(PQ_Heap));
-
-    int total_cnt = counter_0[NODE_0] + counter_0[NODE_1] + counter_0[NODE_2] + counter_0[NODE_3];
-    numa_free(lead_counters_0, counter_0[NODE_0] * sizeof(CounterSlot));
-    numa_free(lead_counters_1, counter_0[NODE_1] * sizeof(CounterSlot));
-    numa_free(lead_counters_2, counter_0[NODE_2] * sizeof(CounterSlot));
-    numa_free(lead_counters_3, counter_0[NODE_3] * sizeof(CounterSlot));
-
-    numa_free(largest_in_leader_0, counter_0[NODE_0] * sizeof(LeaderLargest*));
-    numa_free(largest_in_leader_1, counter_0[NODE_1] * sizeof(LeaderLargest*));
-    numa_free(largest_in_leader_2, counter_0[NODE_2] * sizeof(LeaderLargest*));
-    numa_free(largest_in_leader_3, counter_0[NODE_3] * sizeof(LeaderLargest*));
+    numa_free(heap_0, NUMA_ZONE_THREADS * sizeof(PQ_Heap*));
+    numa_free(heap_1, NUMA_ZONE_THREADS * sizeof(PQ_Heap*));
+    numa_free(heap_2, NUMA_ZONE_THREADS * sizeof(PQ_Heap*));
+    numa_free(heap_3, NUMA_ZONE_THREADS * sizeof(PQ_Heap*));
+
+    numa_free((void*)slot_status_0, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_status_1, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_status_2, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_status_3, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_ready_0, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_ready_1, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_ready_2, NUMA_ZONE_THREADS * sizeof(volatile int));
+    numa_free((void*)slot_ready_3, NUMA_ZONE_THREADS * sizeof(volatile int));
+
+    numa_free(lead_counters_0, NUMA_ZONE_THREADS * sizeof(CounterSlot));
+    numa_free(lead_counters_1, NUMA_ZONE_THREADS * sizeof(CounterSlot));
+    numa_free(lead_counters_2, NUMA_ZONE_THREADS * sizeof(CounterSlot));
+    numa_free(lead_counters_3, NUMA_ZONE_THREADS * sizeof(CounterSlot));
+
+    numa_free(largest_in_leader_0, NUMA_ZONE_THREADS * sizeof(LeaderLargest));
+    numa_free(largest_in_leader_1, NUMA_ZONE_THREADS * sizeof(LeaderLargest));
+    numa_free(largest_in_leader_2, NUMA_ZONE_THREADS * sizeof(LeaderLargest));
+    numa_free(largest_in_leader_3, NUMA_ZONE_THREADS * sizeof(LeaderLargest));
     
     set_destroy(leader_set);
-    numa_free((void*)repeat_keys, total_cnt * sizeof(volatile long long));
+    numa_free((void*)repeat_keys, NUMA_ZONES * NUMA_ZONE_THREADS * sizeof(volatile long long));
 
     numa_free((void*)coord_lock, sizeof(volatile long));
     numa_free((void*)compete_coord_0, sizeof(volatile long));
@@ -387,20 +450,20 @@ void pq_ns::pq<V>::PQDeinit() {
     numa_free(thread_mappings_2, TOTAL_THREADS * sizeof(int));
     numa_free(thread_mappings_3, TOTAL_THREADS * sizeof(int));
 
-    numa_free(announce_coord_0, counter_0[NODE_0] * sizeof(AnnounceStruct));
-    numa_free(announce_coord_1, counter_0[NODE_1] * sizeof(AnnounceStruct));
-    numa_free(announce_coord_2, counter_0[NODE_2] * sizeof(AnnounceStruct));
-    numa_free(announce_coord_3, counter_0[NODE_3] * sizeof(AnnounceStruct));
+    numa_free(announce_coord_0, NUMA_ZONE_THREADS * sizeof(AnnounceStruct));
+    numa_free(announce_coord_1, NUMA_ZONE_THREADS * sizeof(AnnounceStruct));
+    numa_free(announce_coord_2, NUMA_ZONE_THREADS * sizeof(AnnounceStruct));
+    numa_free(announce_coord_3, NUMA_ZONE_THREADS * sizeof(AnnounceStruct));
 
     numa_free(active_numa_zones_0, NUMA_ZONES * sizeof(bool));
     numa_free(active_numa_zones_1, NUMA_ZONES * sizeof(bool));
     numa_free(active_numa_zones_2, NUMA_ZONES * sizeof(bool));
     numa_free(active_numa_zones_3, NUMA_ZONES * sizeof(bool));
 
-    numa_free(delmin_cntr_0, counter_0[NODE_0] * sizeof(DelMinCntr));
-    numa_free(delmin_cntr_1, counter_0[NODE_1] * sizeof(DelMinCntr));
-    numa_free(delmin_cntr_2, counter_0[NODE_2] * sizeof(DelMinCntr));
-    numa_free(delmin_cntr_3, counter_0[NODE_3] * sizeof(DelMinCntr));
+    numa_free(delmin_cntr_0, NUMA_ZONE_THREADS * sizeof(DelMinCntr));
+    numa_free(delmin_cntr_1, NUMA_ZONE_THREADS * sizeof(DelMinCntr));
+    numa_free(delmin_cntr_2, NUMA_ZONE_THREADS * sizeof(DelMinCntr));
+    numa_free(delmin_cntr_3, NUMA_ZONE_THREADS * sizeof(DelMinCntr));
 
     numa_free(counter_0, NUMA_ZONES * sizeof(int));
     numa_free(counter_1, NUMA_ZONES * sizeof(int));
@@ -413,6 +476,7 @@ void pq_ns::pq<V>::HeapDeinit(PQ_Heap** heap) {
     HeapList* list = (*heap)->pq_ptr;
     int size = (*heap)->size;
     numa_free((void*)((*heap)->lock), sizeof(atomic_long));
+    delete (*heap)->tombstones;
     //de-init all lists (in case we allocated additional)
     while (list) {
         HeapList* temp = list->next;
@@ -424,6 +488,146 @@ void pq_ns::pq<V>::HeapDeinit(PQ_Heap** heap) {
     numa_free((*heap), sizeof(PQ_Heap));
 }
 
+/*         --------------------------------------------         */
+/*                                                              */
+/*                 THREAD REGISTRATION METHODS                  */
+/*                                                              */
+/*         --------------------------------------------         */
+
+// claim a free slot in the zone of cpu_id; unlike threadInit, does not wait on the other threads
+template <class V>
+int pq_ns::pq<V>::register_thread(int cpu_id) {
+    if (cpu_id < 0) {
+        cpu_id = sched_getcpu();
+    }
+    int group = get_group(cpu_id);
+    volatile int* slots = get_slot_status(group);
+
+    int idx;
+    for (idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+        if (slots[idx] == SLOT_FREE && __sync_bool_compare_and_swap(&(slots[idx]), SLOT_FREE, SLOT_INIT)) {
+            break;
+        }
+    }
+    if (idx == NUMA_ZONE_THREADS) {
+        COUTATOMIC("register_thread(): no free slot in zone " << group << "\n");
+        return -1;
+    }
+
+    // a recycled slot keeps its heap, leader counter and largest ptr (its elements now belong to this thread)
+    PQ_Heap** heaps = get_worker_heap(group);
+    if (!heaps[idx]) {
+        HeapInit(&(heaps[idx]), group, HEAP_LIST_SIZE);
+    }
+    AnnounceStruct* announce = get_announce_coord(group);
+    announce[idx].status = false;
+    announce[idx].key = EMPTY;
+    announce[idx].detected = 0;
+
+    // publish the slot to the scans only once it is set up; raising the count may expose lower slots that other
+    // threads are still setting up, which the scans skip until they are ready
+    synchFullFence();
+    get_slot_ready(group)[idx] = true;
+    raise_numa_workers(group, idx + 1);
+    synchFullFence();
+    slots[idx] = SLOT_TAKEN;
+
+    t_tid = group * NUMA_ZONE_THREADS + idx;
+    bindThreadSlot(group, idx);
+    return t_tid;
+}
+
+// leave the pq: elements of the worker heap go to the least loaded zone peer, and the slot becomes free.
+// with no peer left in the zone the heap stays in the slot - coordinators still upsert from it, and the next
+// thread to register there takes it over.
+template <class V>
+void pq_ns::pq<V>::unregister_thread() {
+    // keep this zone's coordinator (and its idle scan) out while the heap is handed over
+    while (true) {
+        long lock_value = *t_compete_coord_lock;
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(t_compete_coord_lock, lock_value, lock_value + 1)) {
+            break;
+        }
+    }
+    while (true) {
+        int lock_value = *(t_local_heap->lock);
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(t_local_heap->lock, lock_value, lock_value + 1)) {
+            break;
+        }
+    }
+
+    volatile int* slots = get_slot_status(t_group);
+    volatile int* ready = get_slot_ready(t_group);
+    int peer = -1;
+    int num_workers = get_numa_workers(t_group, t_group);
+    for (int idx = 0; idx < num_workers; idx++) {
+        if (idx != t_idx && ready[idx] && slots[idx] == SLOT_TAKEN) {
+            if (peer == -1 || get_heap_mapping(idx, t_group)->size < get_heap_mapping(peer, t_group)->size) {
+                peer = idx;
+            }
+        }
+    }
+    if (peer != -1 && t_local_heap->size > 0) {
+        adopt_worker_heap(t_local_heap, peer, t_group);
+    }
+
+    *(t_local_heap->lock) = *(t_local_heap->lock) + 1;
+    slots[t_idx] = SLOT_FREE;
+    *t_compete_coord_lock = *t_compete_coord_lock + 1;
+
+    t_local_heap = NULL;
+    t_lead_counters = NULL;
+    t_largest_in_leader = NULL;
+    announce_coord = NULL;
+    t_idx = -1;
+}
+
+// caller holds from's lock and excludes the peer's coordinator. Elements of from below the peer's largest leader element
+// are routed toward the leader as insert_locked does (swapping with the peer's largest once its counter is at
+// COUNTER_MAX), which keeps the peer's leader elements <= its heap elements; the rest are melded into the peer's heap
+// in one pass instead of one sift-up each
+template <class V>
+void pq_ns::pq<V>::adopt_worker_heap(PQ_Heap *from, int peer_idx, int group) {
+    PQ_Heap* peer = get_heap_mapping(peer_idx, group);
+    CounterSlot* cntr = get_counters(group, peer_idx);
+    LeaderLargest* last_ptr = get_last_ptr(peer_idx, group);
+    while (true) {
+        int lock_value = *(peer->lock);
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(peer->lock, lock_value, lock_value + 1)) {
+            break;
+        }
+    }
+    while (from->size > 0 && cntr->count > 0 && last_ptr->largest_ptr && from->pq_ptr->heapList[0].key < last_ptr->largest_ptr->key) {
+        int key;
+        std::optional<V> val = delete_min_worker(from, &key);
+        if (key == EMPTY) {
+            break;
+        }
+        if (cntr->count >= COUNTER_MAX) {
+            k_t dem_key;
+            V dem_val = harris_insert_and_move(leader_set, last_ptr, peer_idx, group, &dem_key, key, val.value());
+            assert(dem_val != EMPTY);
+            insert_worker(peer, dem_key, dem_val);
+        } else if (harris_insert(leader_set, last_ptr, peer_idx, group, key, val.value())) {
+            __sync_fetch_and_add(&(cntr->count), 1);
+        } else {
+            insert_worker(peer, key, val.value()); // the key is already in the leader: keep the element in the heap rather than drop it
+        }
+    }
+    if (from->num_tombstones > 0) { // meld_worker copies the arrays, so drop cancelled elements first
+        compact_worker(from);
+    }
+    if (peer->num_tombstones > 0) {
+        compact_worker(peer);
+    }
+    meld_worker(peer, from, HEAP_LIST_SIZE, group);
+    from->adopted_into |= 1ULL << peer_idx; // remove() follows handles of the moved elements here
+    if (cntr->count == 0) { // delete-min only reaches the heap through a leader element of the slot
+        upsert_worker(peer_idx, group);
+    }
+    *(peer->lock) = *(peer->lock) + 1;
+}
+
 /*         --------------------------------------------         */
 /*                                                              */
 /*                 HELPER / INS & DEL METHODS                   */
@@ -541,85 +745,168 @@ bool pq_ns::pq<V>::getParentList(HeapList** heapList, int* count, int* p_idx, in
 // }
 
 template <class V>
-bool pq_ns::pq<V>::hier_insert_local(int key, V value) { // first call by worker whose operation is to insert
+bool pq_ns::pq<V>::hier_insert_local(int key, V value, PQ_Handle* handle) { // first call by worker whose operation is to insert
+    if (handle) {
+        *handle = {key, value, t_group, t_idx};
+    }
+    while (true) {
+        int lock_value = *(t_local_heap->lock);
+        if (lock_value % 2 == 0) {
+            if (__sync_bool_compare_and_swap(t_local_heap->lock, lock_value, lock_value + 1)) {
+                t_local_heap->heartbeat = t_local_heap->heartbeat + 1;
+                bool ins_ret = insert_locked(key, value);
+
+                if (t_local_heap->num_tombstones > 0 && ++t_compact_cnt >= COMPACT_INTERVAL) {
+                    t_compact_cnt = 0;
+                    if (t_local_heap->num_tombstones >= t_local_heap->size / COMPACT_RATIO) {
+                        compact_worker(t_local_heap);
+                    }
+                }
+
+                *(t_local_heap->lock) = *(t_local_heap->lock) + 1;
+                return ins_ret;
+            }
+        }
+    }
+}
+
+// inserts n elements taking the worker heap lock once. In key order, only the batch's new minima go toward the leader:
+// keys below the slot's largest leader element (or the first one, while the slot has none), routed as by insert_locked
+// but without its helping upserts. Every later key is at least every leader element of the slot, so it goes straight
+// to the heap. Returns how many were inserted
+template <class V>
+int pq_ns::pq<V>::hier_insert_batch(const PQ_Node* elems, int n, PQ_Handle* handles) {
+    if (handles) {
+        for (int i = 0; i < n; i++) {
+            handles[i] = {elems[i].key, elems[i].value, t_group, t_idx};
+        }
+    }
+    std::vector<PQ_Node> sorted(elems, elems + n);
+    std::sort(sorted.begin(), sorted.end(), [](const PQ_Node& a, const PQ_Node& b) { return a.key < b.key; });
     while (true) {
         int lock_value = *(t_local_heap->lock);
         if (lock_value % 2 == 0) {
             if (__sync_bool_compare_and_swap(t_local_heap->lock, lock_value, lock_value + 1)) {
-                bool ins_ret = true;
-                if (t_local_heap->size == 0 || key < t_local_heap->pq_ptr->heapList[0].key) { // reasons to compare to values at leader level
+                t_local_heap->heartbeat = t_local_heap->heartbeat + 1;
+                int inserted = 0;
+                int i = 0;
+                if (n > 0 && t_lead_counters->count == 0 && t_local_heap->size > 0 && t_local_heap->pq_ptr->heapList[0].key <= sorted[0].key) {
+                    upsert_worker(t_idx, t_group); // the heap minimum, not the batch's, is the slot's first leader element
+                }
+                for (; i < n && (t_lead_counters->count == 0 || !t_largest_in_leader->largest_ptr || sorted[i].key < t_largest_in_leader->largest_ptr->key); i++) {
                     if (t_lead_counters->count >= COUNTER_MAX) {
-                        // compare to last_ptr value
-                        if (t_largest_in_leader->largest_ptr && key >= t_largest_in_leader->largest_ptr->key) {
-                            // insert to worker and return
-                            insert_worker(t_local_heap, key, value);
-                            #ifdef TRACK_COUNTERS
-                            t_num_fastpath->count = t_num_fastpath->count + 1;
-                            #endif
-                        } else {
-                            k_t dem_key;
-                            V dem_val = harris_insert_and_move(leader_set, t_largest_in_leader, t_idx, t_group, &dem_key, key, value);
-                            assert(dem_val != EMPTY);
-                            insert_worker(t_local_heap, dem_key, dem_val);
-                            #ifdef TRACK_COUNTERS
-                            t_num_moves->count = t_num_moves->count + 1;
-                            #endif
-                        }
+                        k_t dem_key;
+                        V dem_val = harris_insert_and_move(leader_set, t_largest_in_leader, t_idx, t_group, &dem_key, sorted[i].key, sorted[i].value);
+                        assert(dem_val != EMPTY);
+                        insert_worker(t_local_heap, dem_key, dem_val);
+                        inserted++;
+                        #ifdef TRACK_COUNTERS
+                        t_num_moves->count = t_num_moves->count + 1;
+                        #endif
                     } else {
-                        if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, key, value)) {
+                        if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, sorted[i].key, sorted[i].value)) {
                             __sync_fetch_and_add(&(t_lead_counters->count), 1);
-                        } else {
-                            ins_ret = false;
+                            inserted++;
                         }
                         #ifdef TRACK_COUNTERS
                         t_num_ins->count = t_num_ins->count + 1;
                         #endif
                     }
-                } else {
-                    // insert key at worker (IDEAL CASE)
-                    insert_worker(t_local_heap, key, value);
+                }
+                for (; i < n; i++) {
+                    insert_worker(t_local_heap, sorted[i].key, sorted[i].value);
+                    inserted++;
                     #ifdef TRACK_COUNTERS
                     t_num_fastpath->count = t_num_fastpath->count + 1;
                     #endif
+                }
 
-                    // perform some helping if needed
-                    if (t_lead_counters->count < COUNTER_THRESHOLD) {
-                        int up_key;
-                        std::optional<V> up_val = delete_min_worker(t_local_heap, &up_key);
-                        if (up_key != EMPTY) {
-                            if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, up_key, up_val.value())) {
-                                __sync_fetch_and_add(&(t_lead_counters->count), 1);
-                            } else {
-                                repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + up_key;
-                            }
-                        }
+                if (t_local_heap->num_tombstones > 0 && ++t_compact_cnt >= COMPACT_INTERVAL) {
+                    t_compact_cnt = 0;
+                    if (t_local_heap->num_tombstones >= t_local_heap->size / COMPACT_RATIO) {
+                        compact_worker(t_local_heap);
                     }
                 }
 
-                // perform some helping if needed - //! DESG ONLY !!!! comment out otherwise
-                // if (t_lead_counters->count < COUNTER_THRESHOLD) {
-                //     int cnt = 5;
-                //     while (cnt > 0 && t_lead_counters->count < COUNTER_THRESHOLD) {
-                //         int up_key;
-                //         std::optional<V> up_val = delete_min_worker(t_local_heap, &up_key);
-                //         if (up_key != EMPTY) {
-                //             if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, up_key, up_val.value())) {
-                //                 __sync_fetch_and_add(&(t_lead_counters->count), 1);
-                //                 cnt--;
-                //             } else {
-                //                 repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + up_key;
-                //             }
-                //         } else {
-                //             break;
-                //         }
-                //     }
-                // }
-
                 *(t_local_heap->lock) = *(t_local_heap->lock) + 1;
-                return ins_ret;
+                return inserted;
+            }
+        }
+    }
+}
+
+// routes one insert to the worker heap or the leader; the caller holds the worker heap lock
+template <class V>
+bool pq_ns::pq<V>::insert_locked(int key, V value) {
+    bool ins_ret = true;
+    if (t_local_heap->size == 0 || key < t_local_heap->pq_ptr->heapList[0].key) { // reasons to compare to values at leader level
+        if (t_lead_counters->count >= COUNTER_MAX) {
+            // compare to last_ptr value
+            if (t_largest_in_leader->largest_ptr && key >= t_largest_in_leader->largest_ptr->key) {
+                // insert to worker and return
+                insert_worker(t_local_heap, key, value);
+                #ifdef TRACK_COUNTERS
+                t_num_fastpath->count = t_num_fastpath->count + 1;
+                #endif
+            } else {
+                k_t dem_key;
+                V dem_val = harris_insert_and_move(leader_set, t_largest_in_leader, t_idx, t_group, &dem_key, key, value);
+                assert(dem_val != EMPTY);
+                insert_worker(t_local_heap, dem_key, dem_val);
+                #ifdef TRACK_COUNTERS
+                t_num_moves->count = t_num_moves->count + 1;
+                #endif
+            }
+        } else {
+            if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, key, value)) {
+                __sync_fetch_and_add(&(t_lead_counters->count), 1);
+            } else {
+                ins_ret = false;
+            }
+            #ifdef TRACK_COUNTERS
+            t_num_ins->count = t_num_ins->count + 1;
+            #endif
+        }
+    } else {
+        // insert key at worker (IDEAL CASE)
+        insert_worker(t_local_heap, key, value);
+        #ifdef TRACK_COUNTERS
+        t_num_fastpath->count = t_num_fastpath->count + 1;
+        #endif
+
+        // perform some helping if needed
+        if (t_lead_counters->count < COUNTER_THRESHOLD) {
+            int up_key;
+            std::optional<V> up_val = delete_min_worker(t_local_heap, &up_key);
+            if (up_key != EMPTY) {
+                if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, up_key, up_val.value())) {
+                    __sync_fetch_and_add(&(t_lead_counters->count), 1);
+                } else {
+                    repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] = repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] + up_key;
+                }
             }
         }
     }
+
+    // perform some helping if needed - //! DESG ONLY !!!! comment out otherwise
+    // if (t_lead_counters->count < COUNTER_THRESHOLD) {
+    //     int cnt = 5;
+    //     while (cnt > 0 && t_lead_counters->count < COUNTER_THRESHOLD) {
+    //         int up_key;
+    //         std::optional<V> up_val = delete_min_worker(t_local_heap, &up_key);
+    //         if (up_key != EMPTY) {
+    //             if (harris_insert(leader_set, t_largest_in_leader, t_idx, t_group, up_key, up_val.value())) {
+    //                 __sync_fetch_and_add(&(t_lead_counters->count), 1);
+    //                 cnt--;
+    //             } else {
+    //                 repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + up_key;
+    //             }
+    //         } else {
+    //             break;
+    //         }
+    //     }
+    // }
+    return ins_ret;
 }
 
 
@@ -705,6 +992,7 @@ void pq_ns::pq<V>::insert_worker(PQ_Heap *Heap, int K, V value) { // check defau
 
 template <class V>
 int pq_ns::pq<V>::hier_delete(V* val) { // for sssp
+    t_local_heap->heartbeat = t_local_heap->heartbeat + 1;
     announce_coord[t_idx].status = true;
     try_compete_coordinator();
     int min_priority = announce_coord[t_idx].key;
@@ -714,6 +1002,7 @@ int pq_ns::pq<V>::hier_delete(V* val) { // for sssp
 
 template <class V>
 int pq_ns::pq<V>::hier_delete() { // for microbenchmarks
+    t_local_heap->heartbeat = t_local_heap->heartbeat + 1;
     announce_coord[t_idx].status = true;
     try_compete_coordinator();
     return announce_coord[t_idx].key >= 0 ? announce_coord[t_idx].key : 0;
@@ -758,6 +1047,10 @@ void pq_ns::pq<V>::try_become_coordinator() {
             if (__sync_bool_compare_and_swap(coord_lock, lock_value, lock_value + 1)) {
                 Coordinate();
                 *coord_lock = *coord_lock + 1;
+                if (++t_coord_rounds >= IDLE_SCAN_INTERVAL) { // adoption needs only the zone lock, so other zones go on meanwhile
+                    t_coord_rounds = 0;
+                    scan_idle_workers();
+                }
                 return;
             }
         } else {
@@ -773,8 +1066,10 @@ template <class V>
 void pq_ns::pq<V>::Coordinate() {
     int idx;
     int cnt_numops = 0;
-    for (idx = 0; idx < t_num_workers; idx++) {
-		if(announce_coord[idx].status) { // find active requests from my socket
+    int num_workers = get_numa_workers(t_group, t_group); // re-read: threads may have registered since this one did
+    volatile int* ready = get_slot_ready(t_group);
+    for (idx = 0; idx < num_workers; idx++) {
+		if(ready[idx] && announce_coord[idx].status) { // find active requests from my socket
             delete_min_leader(idx);
 			announce_coord[idx].status = false;
             cnt_numops++;
@@ -783,6 +1078,42 @@ void pq_ns::pq<V>::Coordinate() {
     //reset_head_ptr(leader_set);
 }
 
+// called by the coordinator after it releases coord_lock (still holding the zone lock, so no other same-zone thread is coordinating):
+// merges heaps that stopped making progress into our own so their elements don't wait on the rest of the zone.
+// released slots count as idle too, which also picks up heaps left behind by unregister_thread().
+template <class V>
+void pq_ns::pq<V>::scan_idle_workers() {
+    int num_workers = get_numa_workers(t_group, t_group);
+    volatile int* ready = get_slot_ready(t_group);
+    for (int idx = 0; idx < num_workers; idx++) {
+        if (idx == t_idx || !ready[idx]) {
+            continue;
+        }
+        PQ_Heap* worker = get_heap_mapping(idx, t_group);
+        if (!worker) {
+            continue;
+        }
+        long heartbeat = worker->heartbeat;
+        if (heartbeat != worker->last_heartbeat || worker->size == 0) {
+            worker->last_heartbeat = heartbeat;
+            worker->idle_scans = 0;
+            continue;
+        }
+        if (++(worker->idle_scans) < IDLE_SCAN_ROUNDS) {
+            continue;
+        }
+
+        int lock_value = *(worker->lock);
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(worker->lock, lock_value, lock_value + 1)) { // owner busy => not idle
+            if (worker->heartbeat == heartbeat) {
+                adopt_worker_heap(worker, t_idx, t_group);
+            }
+            *(worker->lock) = *(worker->lock) + 1;
+        }
+        worker->idle_scans = 0;
+    }
+}
+
 template <class V>
 void pq_ns::pq<V>::delete_min_leader(int idx) {
     k_t del_key;
@@ -797,24 +1128,31 @@ void pq_ns::pq<V>::delete_min_leader(int idx) {
         announce_coord[idx].value = retval;
 
         if (cntr->count < counter_tsh) { // need to upsert before we can do next del-min
-            if (t_group == del_zone && t_idx == del_idx) { // don't have to lock worker
+            if (t_group == del_zone && t_idx == del_idx) { // our own heap: no one else upserts from it, but remove() may be reading it
+                while (true) {
+                    int lock_value = *(t_local_heap->lock);
+                    if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(t_local_heap->lock, lock_value, lock_value + 1)) {
+                        break;
+                    }
+                }
                 while (1) {
                     int key_worker;
                     std::optional<V> ret = delete_min_worker(t_local_heap, &key_worker);
+                    if (cntr->count == 0) { // also with an empty heap, so the ptr never outlives the deleted node
+                        t_largest_in_leader->largest_ptr = NULL;
+                    }
                     if (key_worker != EMPTY) {
-                        if (cntr->count == 0) {
-                            t_largest_in_leader->largest_ptr = NULL;
-                        }
                         if (harris_insert(leader_set, t_largest_in_leader, del_idx, del_zone, key_worker, ret.value())) { // if fail, key and value are already present, so remove another from worker and try to insert
                             __sync_add_and_fetch(&(cntr->count), 1);
                             break;
                         } else {
-                            repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + key_worker;
+                            repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] = repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] + key_worker;
                         }
                     } else {
-                        return;
+                        break;
                     }
                 }
+                *(t_local_heap->lock) = *(t_local_heap->lock) + 1;
             } else {
                 // lock worker
                 PQ_Heap *worker = get_heap_mapping(del_idx, del_zone);
@@ -835,7 +1173,7 @@ void pq_ns::pq<V>::delete_min_leader(int idx) {
                                             __sync_add_and_fetch(&(cntr->count), 1);
                                             break;
                                         } else {
-                                            repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + key_worker;
+                                            repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] = repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] + key_worker;
                                         }
                                     } else {
                                         break;
@@ -875,7 +1213,7 @@ void pq_ns::pq<V>::help_upsert() {
                             __sync_add_and_fetch(&(t_lead_counters->count), 1);
                             break;
                         } else {
-                            repeat_keys[t_group*24 + t_idx] = repeat_keys[t_group*24 + t_idx] + key_worker;
+                            repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] = repeat_keys[t_group*NUMA_ZONE_THREADS + t_idx] + key_worker;
                         }
                     } else {
                         break;
@@ -888,8 +1226,18 @@ void pq_ns::pq<V>::help_upsert() {
     }
 }
 
+// removes the smallest element of a worker heap that has not been cancelled
 template <class V>
 std::optional<V> pq_ns::pq<V>::delete_min_worker(PQ_Heap *Heap, int* key) {
+    std::optional<V> ret = pop_min_worker(Heap, key);
+    while (*key != EMPTY && consume_tombstone(Heap, *key, ret.value())) {
+        ret = pop_min_worker(Heap, key);
+    }
+    return ret;
+}
+
+template <class V>
+std::optional<V> pq_ns::pq<V>::pop_min_worker(PQ_Heap *Heap, int* key) {
     if ((Heap->size) == 0) {
         *key = EMPTY;
         return {};
@@ -978,7 +1326,8 @@ std::optional<V> pq_ns::pq<V>::delete_min_worker(PQ_Heap *Heap, int* key) {
             // reset variables
             m_idx = l_idx;
             m_virt = l_virt;
-             
+            heapListM = heapListLChild; // the left child may live in the next list
+
             break;
         }
         
@@ -997,4 +1346,603 @@ std::optional<V> pq_ns::pq<V>::delete_min_worker(PQ_Heap *Heap, int* key) {
     (heapListM->heapList)[m_idx].key = K;
     (heapListM->heapList)[m_idx].value = val;
     return retVal;
-}
\ No newline at end of file
+}
+/*         --------------------------------------------         */
+/*                                                              */
+/*                        MELD METHODS                          */
+/*                                                              */
+/*         --------------------------------------------         */
+
+// collect the lists of a worker heap so that element i is chunks[i / HEAP_LIST_SIZE]->heapList[i % HEAP_LIST_SIZE],
+// allocating lists (on NUMA node group) until num_elements fit
+template <class V>
+void pq_ns::pq<V>::getHeapChunks(PQ_Heap *Heap, std::vector<HeapList*>& chunks, int num_elements, int group) {
+    chunks.clear();
+    HeapList* list = Heap->pq_ptr;
+    chunks.push_back(list);
+    while ((int)chunks.size() * HEAP_LIST_SIZE < num_elements) {
+        if (!list->next) {
+            list->next = (HeapList*)numa_alloc_onnode(sizeof(HeapList), group);
+            list->next->heapList = (PQ_Node*)numa_alloc_onnode(HEAP_LIST_SIZE * sizeof(PQ_Node), group);
+            list->next->prev = list;
+            list->next->next = nullptr;
+        }
+        list = list->next;
+        chunks.push_back(list);
+    }
+}
+
+// bottom-up (Floyd) heap construction over the first Heap->size elements - O(n) rather than n sift-ups
+template <class V>
+void pq_ns::pq<V>::heapify_worker(PQ_Heap *Heap, std::vector<HeapList*>& chunks) {
+    int size = Heap->size;
+    auto node = [&](int i) -> PQ_Node& { return chunks[i / HEAP_LIST_SIZE]->heapList[i % HEAP_LIST_SIZE]; };
+
+    for (int start = PARENT(size - 1); start >= 0; start--) {
+        PQ_Node moving = node(start);
+        int m_virt = start;
+        while (LEFT_CHILD(m_virt) < size) {
+            int c_virt = LEFT_CHILD(m_virt);
+            if (c_virt + 1 < size && node(c_virt + 1).key < node(c_virt).key) {
+                c_virt++;
+            }
+            if (node(c_virt).key >= moving.key) {
+                break;
+            }
+            node(m_virt) = node(c_virt);
+            m_virt = c_virt;
+        }
+        node(m_virt) = moving;
+    }
+}
+
+// moves all elements of src (whose lists hold src_list_size elements each) into dest, leaving src empty
+template <class V>
+void pq_ns::pq<V>::meld_worker(PQ_Heap *dest, PQ_Heap *src, int src_list_size, int group) {
+    if (src->size == 0) {
+        return;
+    }
+    if (dest->size < src->size && src_list_size == HEAP_LIST_SIZE) {
+        // keep the bigger array in place by swapping contents (dest keeps its address and lock, which its owner holds on to)
+        HeapList* temp_list = dest->pq_ptr;
+        int temp_size = dest->size;
+        dest->pq_ptr = src->pq_ptr;
+        dest->size = src->size;
+        src->pq_ptr = temp_list;
+        src->size = temp_size;
+        if (src->size == 0) {
+            return;
+        }
+    }
+
+    HeapList* list = src->pq_ptr;
+    if (src->size * log2(dest->size + src->size) < dest->size) {
+        // a few elements into a big heap - sifting each one up is cheaper than rebuilding
+        for (int j = 0; j < src->size; j++) {
+            if (j > 0 && j % src_list_size == 0) {
+                list = list->next;
+            }
+            insert_worker(dest, list->heapList[j % src_list_size].key, list->heapList[j % src_list_size].value);
+        }
+    } else {
+        std::vector<HeapList*> chunks;
+        getHeapChunks(dest, chunks, dest->size + src->size, group);
+        int pos = dest->size;
+        for (int j = 0; j < src->size; j++, pos++) {
+            if (j > 0 && j % src_list_size == 0) {
+                list = list->next;
+            }
+            chunks[pos / HEAP_LIST_SIZE]->heapList[pos % HEAP_LIST_SIZE] = list->heapList[j % src_list_size];
+        }
+        dest->size = pos;
+        heapify_worker(dest, chunks);
+    }
+    src->size = ROOT;
+}
+
+// merge other into this pq: heaps are melded slot by slot (a leader node of other keeps its (idx, zone), so it pairs with
+// the same slot here), the leader lists are merged in one pass, and any heap element that is now below its slot's
+// largest leader element is moved up, restoring leader <= heap per slot. other is left empty and can be reused.
+// the leader holds each key once, so an element set_merge() rejected goes to the worker heap of the slot owning the
+// equal leader key. That slot's leader elements above the key go down with it, so its leader stays <= its heap.
+template <class V>
+void pq_ns::pq<V>::place_rejected(std::vector<node__t*>& rejected, node__t* largest[], int count[]) {
+    if (rejected.empty()) {
+        return;
+    }
+    k_t trim_above[NUMA_ZONES * NUMA_ZONE_THREADS];
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        trim_above[i] = KEY_MAX;
+    }
+    for (node__t* node : rejected) {
+        int slot = node->zone * NUMA_ZONE_THREADS + node->idx;
+        trim_above[slot] = min(trim_above[slot], node->key);
+    }
+    set_trim(leader_set, trim_above, largest, count, rejected); // the equal keys stay, so no slot loses all of its leader elements
+
+    for (node__t* node : rejected) {
+        PQ_Heap** heaps = get_worker_heap(node->zone);
+        if (!heaps[node->idx]) {
+            HeapInit(&(heaps[node->idx]), node->zone, HEAP_LIST_SIZE);
+            get_slot_ready(node->zone)[node->idx] = true;
+        }
+        insert_worker(heaps[node->idx], node->key, (V) node->val);
+        raise_numa_workers(node->zone, node->idx + 1);
+        free(node);
+    }
+    rejected.clear();
+}
+
+template <class V>
+void pq_ns::pq<V>::meld(pq& other) {
+    if (&other == this) {
+        return;
+    }
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* src = other.get_heap_mapping(idx, group);
+            if (!src || src->size == 0) {
+                continue;
+            }
+            PQ_Heap** heaps = get_worker_heap(group);
+            if (!heaps[idx]) {
+                HeapInit(&(heaps[idx]), group, HEAP_LIST_SIZE);
+                get_slot_ready(group)[idx] = true;
+            }
+            if (src->num_tombstones > 0) { // meld_worker copies the arrays, so drop cancelled elements first
+                other.compact_worker(src);
+            }
+            if (heaps[idx]->num_tombstones > 0) {
+                compact_worker(heaps[idx]);
+            }
+            meld_worker(heaps[idx], src, other.HEAP_LIST_SIZE, group);
+            raise_numa_workers(group, idx + 1);
+        }
+    }
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        repeat_keys[i] = repeat_keys[i] + other.repeat_keys[i];
+        other.repeat_keys[i] = 0;
+    }
+
+    node__t* largest[NUMA_ZONES * NUMA_ZONE_THREADS];
+    int count[NUMA_ZONES * NUMA_ZONE_THREADS];
+    std::vector<node__t*> rejected; // keys both leaders hold
+    set_merge(leader_set, other.leader_set, largest, count, rejected);
+
+    // heap elements below the slot's largest leader element (or the minimum, if the slot has no leader element) go up
+    std::vector<node__t*> upsert;
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            node__t* last = largest[group * NUMA_ZONE_THREADS + idx];
+            while (heap && heap->size > 0 && (!last || heap->pq_ptr->heapList[0].key < last->key)) {
+                int key;
+                std::optional<V> val = delete_min_worker(heap, &key);
+                upsert.push_back(new_node(key, val.value(), idx, group, nullptr));
+                if (!last) {
+                    break;
+                }
+            }
+        }
+    }
+    if (!upsert.empty()) {
+        std::sort(upsert.begin(), upsert.end(), [](node__t* a, node__t* b) { return a->key < b->key; });
+        intset_t* sorted = set_new(MAX_OFFSET);
+        node__t* prev = sorted->head;
+        for (node__t* node : upsert) {
+            node->next = sorted->tail;
+            prev->next = node;
+            prev = node;
+        }
+        set_merge(leader_set, sorted, largest, count, rejected);
+        set_destroy(sorted);
+    }
+    place_rejected(rejected, largest, count);
+
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            get_counters(group, idx)->count = count[group * NUMA_ZONE_THREADS + idx];
+            get_last_ptr(idx, group)->largest_ptr = largest[group * NUMA_ZONE_THREADS + idx];
+            if (count[group * NUMA_ZONE_THREADS + idx] > 0) {
+                PQ_Heap** heaps = get_worker_heap(group);
+                if (!heaps[idx]) { // coordinators upsert from the heap of any slot that has leader elements
+                    HeapInit(&(heaps[idx]), group, HEAP_LIST_SIZE);
+                    get_slot_ready(group)[idx] = true;
+                }
+                raise_numa_workers(group, idx + 1);
+            }
+            other.get_counters(group, idx)->count = 0;
+            other.get_last_ptr(idx, group)->largest_ptr = NULL;
+        }
+    }
+}
+
+// empty the pq for reuse (quiescent): the worker heaps keep their allocated lists and are just truncated, the leader
+// list is swapped for a new one, and the per-slot leader bookkeeping and cancellations are reset
+template <class V>
+void pq_ns::pq<V>::clear() {
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            if (heap) {
+                heap->size = 0;
+                if (heap->tombstones) {
+                    heap->tombstones->clear();
+                }
+                heap->num_tombstones = 0;
+                heap->adopted_into = 0;
+            }
+            get_counters(group, idx)->count = 0;
+            get_last_ptr(idx, group)->largest_ptr = NULL;
+        }
+    }
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        repeat_keys[i] = 0;
+    }
+    intset_t* old = leader_set;
+    leader_set = set_new(MAX_OFFSET);
+    set_destroy(old);
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                      REMOVE METHODS                          */
+/*                                                              */
+/*         --------------------------------------------         */
+
+// cancel an element. The handle names the slot it was inserted from, and the element is still in that slot's heap
+// (tombstoned there until a delete-min or compaction of the heap meets it), in the leader (unlinked), or in the heap
+// of a zone peer that took over the slot's heap (adopt_worker_heap records those in adopted_into)
+template <class V>
+bool pq_ns::pq<V>::remove(PQ_Handle handle) {
+    PQ_Heap* heap = get_heap_mapping(handle.idx, handle.zone);
+    if (!heap) {
+        return false;
+    }
+    // common case: the element is still in its heap, which takes only that heap's lock
+    while (true) {
+        int lock_value = *(heap->lock);
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(heap->lock, lock_value, lock_value + 1)) {
+            break;
+        }
+    }
+    bool found = cancel_in_heap(heap, handle.key, handle.value);
+    *(heap->lock) = *(heap->lock) + 1;
+    if (found) {
+        return true;
+    }
+
+    // no coordinator may run linden_delete_min while we unlink from the leader, and holding a slot's heap lock keeps
+    // its elements from moving between its heap and the leader while we look in both
+    while (true) {
+        long lock_value = *coord_lock;
+        if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(coord_lock, lock_value, lock_value + 1)) {
+            break;
+        }
+    }
+    node__t* removed = NULL;
+    int del_idx, del_zone;
+    unsigned long long visited = 0;
+    unsigned long long pending = 1ULL << handle.idx;
+    while (!found && !removed && pending) {
+        int idx = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        visited |= 1ULL << idx;
+        heap = get_heap_mapping(idx, handle.zone);
+        if (!heap) {
+            continue;
+        }
+        while (true) {
+            int lock_value = *(heap->lock);
+            if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(heap->lock, lock_value, lock_value + 1)) {
+                break;
+            }
+        }
+        found = cancel_in_heap(heap, handle.key, handle.value);
+        if (!found) {
+            removed = harris_remove(leader_set, handle.key, handle.value, &del_idx, &del_zone);
+            pending |= heap->adopted_into & ~visited;
+        }
+        *(heap->lock) = *(heap->lock) + 1;
+    }
+
+    if (removed) {
+        // the owner of the element's slot compares its inserts against the largest ptr, so fix it under that heap's lock
+        PQ_Heap* worker = get_heap_mapping(del_idx, del_zone);
+        CounterSlot* cntr = get_counters(del_zone, del_idx);
+        LeaderLargest* last_ptr = get_last_ptr(del_idx, del_zone);
+        while (true) {
+            int lock_value = *(worker->lock);
+            if (lock_value % 2 == 0 && __sync_bool_compare_and_swap(worker->lock, lock_value, lock_value + 1)) {
+                break;
+            }
+        }
+        __sync_add_and_fetch(&(cntr->count), -1);
+        if (last_ptr->largest_ptr == removed) { // inserts compare against it, so it may not dangle
+            last_ptr->largest_ptr = cntr->count > 0 ? set_last_of_slot(leader_set, del_idx, del_zone) : NULL;
+        }
+        if (cntr->count < 2) { // same threshold as delete_min_leader
+            upsert_worker(del_idx, del_zone);
+        }
+        *(worker->lock) = *(worker->lock) + 1;
+        found = true;
+    }
+    *coord_lock = *coord_lock + 1;
+    return found;
+}
+
+// tombstone (key, value) in Heap if Heap holds more copies of it than it has tombstones for (caller holds Heap's
+// lock). Only the top of the heap down to key is searched: every element below a node is at least the node's key
+template <class V>
+bool pq_ns::pq<V>::cancel_in_heap(PQ_Heap *Heap, int key, V value) {
+    if (Heap->size == 0 || Heap->pq_ptr->heapList[0].key > key) {
+        return false;
+    }
+    std::vector<HeapList*> chunks;
+    getHeapChunks(Heap, chunks, Heap->size, 0); // no chunk is missing, so nothing is allocated
+    auto node = [&](int i) -> PQ_Node& { return chunks[i / HEAP_LIST_SIZE]->heapList[i % HEAP_LIST_SIZE]; };
+
+    int copies = 0;
+    std::vector<int> stack(1, ROOT);
+    while (!stack.empty()) {
+        int i = stack.back();
+        stack.pop_back();
+        if (i >= Heap->size || node(i).key > key) {
+            continue;
+        }
+        if (node(i).key == key && node(i).value == value) {
+            copies++;
+        }
+        stack.push_back(LEFT_CHILD(i));
+        stack.push_back(RIGHT_CHILD(i));
+    }
+    if (copies == 0 || (Heap->tombstones && (int)Heap->tombstones->count(std::make_pair(key, value)) >= copies)) {
+        return false;
+    }
+    if (!Heap->tombstones) {
+        Heap->tombstones = new std::multiset<std::pair<int, V>>();
+    }
+    Heap->tombstones->insert(std::make_pair(key, value));
+    Heap->num_tombstones = Heap->num_tombstones + 1;
+    return true;
+}
+
+// if (key, value) was cancelled in Heap, use up its tombstone and return true (caller holds Heap's lock)
+template <class V>
+bool pq_ns::pq<V>::consume_tombstone(PQ_Heap *Heap, int key, V value) {
+    if (Heap->num_tombstones == 0) {
+        return false;
+    }
+    auto it = Heap->tombstones->find(std::make_pair(key, value));
+    if (it == Heap->tombstones->end()) {
+        return false;
+    }
+    Heap->tombstones->erase(it);
+    Heap->num_tombstones = Heap->num_tombstones - 1;
+    return true;
+}
+
+// drop every cancelled element from Heap and rebuild it (caller holds Heap's lock)
+template <class V>
+void pq_ns::pq<V>::compact_worker(PQ_Heap *Heap) {
+    std::vector<HeapList*> chunks;
+    getHeapChunks(Heap, chunks, Heap->size, 0); // no chunk is missing, so nothing is allocated
+    auto node = [&](int i) -> PQ_Node& { return chunks[i / HEAP_LIST_SIZE]->heapList[i % HEAP_LIST_SIZE]; };
+
+    int kept = 0;
+    for (int i = 0; i < Heap->size; i++) {
+        if (!consume_tombstone(Heap, node(i).key, node(i).value)) {
+            node(kept++) = node(i);
+        }
+    }
+    Heap->size = kept;
+    heapify_worker(Heap, chunks);
+}
+
+// move one element of slot (idx, zone) up to the leader - the caller holds the worker's lock, and coord_lock unless the
+// slot has no leader element (then no coordinator touches its counter or largest ptr)
+template <class V>
+void pq_ns::pq<V>::upsert_worker(int idx, int zone) {
+    PQ_Heap* worker = get_heap_mapping(idx, zone);
+    CounterSlot* cntr = get_counters(zone, idx);
+    LeaderLargest* last_ptr = get_last_ptr(idx, zone);
+    while (1) {
+        int key_worker;
+        std::optional<V> ret = delete_min_worker(worker, &key_worker);
+        if (cntr->count == 0) {
+            last_ptr->largest_ptr = NULL;
+        }
+        if (key_worker != EMPTY) {
+            if (harris_insert(leader_set, last_ptr, idx, zone, key_worker, ret.value())) {
+                __sync_add_and_fetch(&(cntr->count), 1);
+                break;
+            } else {
+                repeat_keys[zone*NUMA_ZONE_THREADS + idx] = repeat_keys[zone*NUMA_ZONE_THREADS + idx] + key_worker;
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+/*         --------------------------------------------         */
+/*                                                              */
+/*                    CHECKPOINT METHODS                        */
+/*                                                              */
+/*         --------------------------------------------         */
+
+// write the pq to path: a pass over the leader list plus one sequential write per worker heap list
+template <class V>
+bool pq_ns::pq<V>::checkpoint(const char* path) {
+    static_assert(std::is_trivially_copyable<V>::value, "checkpoint writes values as raw bytes");
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        COUTATOMIC("checkpoint(): cannot open " << path << "\n");
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 22);
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.num_zones = NUMA_ZONES;
+    header.zone_slots = NUMA_ZONE_THREADS;
+    header.node_size = sizeof(PQ_Node);
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            if (heap && heap->num_tombstones > 0) { // the arrays are written as they are, so drop cancelled elements first
+                compact_worker(heap);
+            }
+            header.heap_size[group * NUMA_ZONE_THREADS + idx] = heap ? heap->size : 0;
+        }
+    }
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        header.repeat_keys[i] = repeat_keys[i];
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1; // leader_size is filled in at the end
+
+    // leader: live nodes only, already sorted
+    node__t* node = leader_set->head->next;
+    while (ok && (node__t*)get_unmarked_reference(node) != leader_set->tail) {
+        if (is_marked_reference(node)) {
+            node = ((node__t*)get_unmarked_reference(node))->next;
+            continue;
+        }
+        CheckpointLeaderEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.key = node->key;
+        entry.slot = node->zone * NUMA_ZONE_THREADS + node->idx;
+        entry.value = (V)node->val;
+        ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+        header.leader_size++;
+        node = node->next;
+    }
+
+    // worker heaps: the arrays as they are (heap order only depends on the element's index)
+    for (int group = 0; ok && group < NUMA_ZONES; group++) {
+        for (int idx = 0; ok && idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            if (!heap) {
+                continue;
+            }
+            HeapList* list = heap->pq_ptr;
+            for (int written = 0; ok && written < heap->size; written += HEAP_LIST_SIZE) {
+                int num = min(HEAP_LIST_SIZE, heap->size - written);
+                ok = fwrite(list->heapList, sizeof(PQ_Node), num, file) == (size_t)num;
+                list = list->next;
+            }
+        }
+    }
+
+    if (ok) {
+        ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        COUTATOMIC("checkpoint(): write to " << path << " failed\n");
+    }
+    return ok;
+}
+
+// load a checkpoint into this (empty) pq: the file is mapped, heap arrays are copied list by list without sifting,
+// and the leader list is rebuilt by appending (it was saved in order)
+template <class V>
+bool pq_ns::pq<V>::restore(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        COUTATOMIC("restore(): cannot open " << path << "\n");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CheckpointHeader)) {
+        COUTATOMIC("restore(): " << path << " is not a checkpoint\n");
+        close(fd);
+        return false;
+    }
+    char* data = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        COUTATOMIC("restore(): cannot map " << path << "\n");
+        return false;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    CheckpointHeader* header = (CheckpointHeader*)data;
+    size_t expected = sizeof(CheckpointHeader) + header->leader_size * sizeof(CheckpointLeaderEntry);
+    for (int i = 0; i < NUMA_ZONES * NUMA_ZONE_THREADS; i++) {
+        expected += header->heap_size[i] * sizeof(PQ_Node);
+    }
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0 || header->version != CHECKPOINT_VERSION ||
+            header->num_zones != NUMA_ZONES || header->zone_slots != NUMA_ZONE_THREADS ||
+            header->node_size != (int)sizeof(PQ_Node) || expected != (size_t)st.st_size) {
+        COUTATOMIC("restore(): " << path << " does not match this build's layout\n");
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    bool empty = (node__t*)get_unmarked_reference(leader_set->head->next) == leader_set->tail;
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            PQ_Heap* heap = get_heap_mapping(idx, group);
+            empty = empty && (!heap || heap->size == 0);
+        }
+    }
+    if (!empty) {
+        COUTATOMIC("restore(): the pq is not empty\n");
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    // leader
+    CheckpointLeaderEntry* entries = (CheckpointLeaderEntry*)(data + sizeof(CheckpointHeader));
+    intset_t* saved = set_new(MAX_OFFSET);
+    node__t* prev = saved->head;
+    for (long long i = 0; i < header->leader_size; i++) {
+        node__t* node = new_node(entries[i].key, entries[i].value, entries[i].slot % NUMA_ZONE_THREADS, entries[i].slot / NUMA_ZONE_THREADS, saved->tail);
+        prev->next = node;
+        prev = node;
+    }
+    node__t* largest[NUMA_ZONES * NUMA_ZONE_THREADS];
+    int count[NUMA_ZONES * NUMA_ZONE_THREADS];
+    std::vector<node__t*> rejected; // only if the file repeats a leader key
+    set_merge(leader_set, saved, largest, count, rejected);
+    set_destroy(saved);
+
+    // worker heaps
+    PQ_Node* nodes = (PQ_Node*)(entries + header->leader_size);
+    std::vector<HeapList*> chunks;
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        PQ_Heap** heaps = get_worker_heap(group);
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            int slot = group * NUMA_ZONE_THREADS + idx;
+            int size = header->heap_size[slot];
+            repeat_keys[slot] = header->repeat_keys[slot];
+            if (size == 0 && count[slot] == 0) {
+                continue;
+            }
+            if (!heaps[idx]) {
+                HeapInit(&(heaps[idx]), group, HEAP_LIST_SIZE);
+                get_slot_ready(group)[idx] = true;
+            }
+            getHeapChunks(heaps[idx], chunks, size, group);
+            for (int copied = 0; copied < size; copied += HEAP_LIST_SIZE) {
+                memcpy(chunks[copied / HEAP_LIST_SIZE]->heapList, nodes + copied, min(HEAP_LIST_SIZE, size - copied) * sizeof(PQ_Node));
+            }
+            heaps[idx]->size = size;
+            nodes += size;
+            raise_numa_workers(group, idx + 1);
+        }
+    }
+    place_rejected(rejected, largest, count);
+    for (int group = 0; group < NUMA_ZONES; group++) {
+        for (int idx = 0; idx < NUMA_ZONE_THREADS; idx++) {
+            get_counters(group, idx)->count = count[group * NUMA_ZONE_THREADS + idx];
+            get_last_ptr(idx, group)->largest_ptr = largest[group * NUMA_ZONE_THREADS + idx];
+        }
+    }
+
+    munmap(data, st.st_size);
+    return true;
+}
@@ -133,7 +133,7 @@ long long set_keysum(intset_t *set) {
   return sum;
 }
 
-int set_validate(intset_t *set, int largest_per_idx[96]) {
+int set_validate(intset_t *set, int largest_per_idx[], int zone_slots) {
   node__t *node;
   long long cur;
   int prev_key = -2;
@@ -141,8 +141,6 @@ int set_validate(intset_t *set, int largest_per_idx[96]) {
 
   int cnt = 0;
 
-  int myArray[96] = { 0 };
-
   /* We have at least 2 elements */
   node = set->head->next;
   while ((node__t*)get_unmarked_reference(node) != set->tail) {
@@ -153,10 +151,7 @@ int set_validate(intset_t *set, int largest_per_idx[96]) {
 		cnt++;
 		cur = node->key;
 
-		myArray[node->zone * 24 + node->idx]++;
-		//std::cout << "[tid=" << node->zone * 24 + node->idx << "] " << cur << " {" << myArray[node->zone * 24 + node->idx] << "}\n";
-
-		largest_per_idx[node->zone * 24 + node->idx] = cur;
+		largest_per_idx[node->zone * zone_slots + node->idx] = cur;
 		if (prev_key > cur) {
 			std::cout << "INCORRECT ORDER! prev_key = " << prev_key << ", cur_key = " << cur << "\n";
 			num_incorrect++;
@@ -470,6 +465,83 @@ val__t harris_delete_idx(intset_t *set, int idx, int zone, k_t* key) {
 	return ret_val;
 }
 
+/*
+ * harris_search_kv finds the first unmarked node holding (key, val), unlinking marked nodes before it.
+ * Returns nullptr if there is none.
+ */
+node__t *harris_search_kv(intset_t *set, k_t key, val__t val, node__t **left_node) {
+	node__t *left_node_next, *right_node, *cur_left_node, *cur_left_node_next;
+
+	do {
+		node__t *x = set->head;
+		node__t *x_next = x->next;
+		right_node = nullptr;
+
+		/* 1. Find left_node and right_node */
+		do {
+			if (!is_moving_ref(x_next)) {
+				cur_left_node = x;
+				cur_left_node_next = (node__t *)get_notlogdel_ref(x_next); // in case x_next as logically deleted
+			}
+			bool prev_logdel = is_logdel_ref(x_next);
+			x = (node__t *) get_unmarked_reference(x_next);
+			if (x == set->tail || x->key > key) break;
+			x_next = x->next;
+
+			if (!prev_logdel && !is_moving_ref(x_next) && x->key == key && x->val == val) {
+				(*left_node) = cur_left_node;
+				left_node_next = cur_left_node_next;
+				right_node = x;
+				break;
+			}
+		} while (1);
+
+		if (!right_node) {
+			return nullptr;
+		}
+
+		/* 2. Check that nodes are adjacent */
+		if (left_node_next == right_node) return right_node;
+
+		/* 3. Remove one or more marked nodes */
+		if (__sync_bool_compare_and_swap(&(*left_node)->next, left_node_next, right_node)) return right_node;
+	} while (1);
+}
+
+/*
+ * harris_remove unlinks the node holding (key, val) from anywhere in the list, claiming it with the
+ * same "moving" mark as harris_delete_idx. Returns the node (not freed, so the caller can tell whether
+ * a largest ptr pointed at it), or nullptr if no such node is in the list.
+ * The caller must keep linden_delete_min from running concurrently.
+ */
+node__t *harris_remove(intset_t *set, k_t key, val__t val, int* idx, int* zone) {
+	node__t *right_node, *right_node_next, *left_node;
+	left_node = set->head;
+
+	do {
+		right_node = harris_search_kv(set, key, val, &left_node);
+		if (!right_node) {
+			return nullptr;
+		}
+
+		right_node_next = right_node->next;
+
+		if (!is_marked_reference(right_node_next)) {
+			if (__sync_bool_compare_and_swap(&right_node->next, right_node_next, get_moving_ref(right_node_next))) {
+				break;
+			}
+		}
+	} while(1);
+
+	*idx = right_node->idx;
+	*zone = right_node->zone;
+
+	if (!__sync_bool_compare_and_swap(&left_node->next, right_node, right_node_next)) {
+		harris_search_physdel(set, right_node);
+	}
+	return right_node;
+}
+
 val__t linden_delete_min(intset_t *set, k_t* del_key, int* del_idx, int* del_zone) {
 	node__t *x, *x_next; //, *new_head; //, *obs_head;
 
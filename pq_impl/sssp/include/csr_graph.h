@@ -0,0 +1,267 @@
+// graphs in compressed sparse row form: a parallel parser for the text edge
+// lists, and a binary format that is mmapped and used without copying
+//
+// Text: a "# Nodes: <n> Edges: <m>" line, then one "<u> <v>" edge per line
+// (other lines starting with '#' are skipped). Edges keep their file order
+// within each source node, and the weight functor is called once per edge in
+// file order, so weights drawn from a seeded rand() match the old parser.
+//
+// Binary: csr_header, then offsets (nb_nodes + 1 uint64_t) and edges
+// (nb_edges csr_edge). The edges of node u are [offsets[u], offsets[u + 1]);
+// each edge keeps its target and weight together, so relaxing a node reads
+// one sequential stream.
+
+#pragma once
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CSR_MAGIC "PQCSRGR"
+#define CSR_VERSION 2 // 2: targets and weights interleaved
+
+struct csr_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t nb_nodes;
+  uint64_t nb_edges;
+};
+
+struct csr_edge {
+  int32_t target;
+  int32_t weight;
+};
+
+struct csr_graph {
+  uint64_t nb_nodes = 0;
+  uint64_t nb_edges = 0;
+  const uint64_t *offsets = nullptr;
+  const csr_edge *edges = nullptr;
+
+  // backing storage: either a read-only mapping of a binary file, or arrays
+  // owned by the graph after parsing a text file
+  void *map = nullptr;
+  size_t map_size = 0;
+  std::vector<uint64_t> own_offsets;
+  std::vector<csr_edge> own_edges;
+
+  csr_graph() = default;
+  csr_graph(const csr_graph &) = delete;
+  csr_graph &operator=(const csr_graph &) = delete;
+  ~csr_graph() {
+    if (map != nullptr)
+      munmap(map, map_size);
+  }
+};
+
+inline std::runtime_error csr_error(const char *what, const char *path) {
+  std::string msg = what;
+  msg += path;
+  return std::runtime_error(msg);
+}
+
+/// True if path starts with the binary CSR magic.
+inline bool csr_is_binary(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  char magic[8];
+  bool binary = read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+                memcmp(magic, CSR_MAGIC, sizeof(magic)) == 0;
+  close(fd);
+  return binary;
+}
+
+/// Maps a binary CSR file read-only; the arrays point into the mapping.
+inline void csr_map(const char *path, csr_graph &g) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    throw csr_error("Couldn't open file: ", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(csr_header)) {
+    close(fd);
+    throw csr_error("Not a CSR graph: ", path);
+  }
+  g.map_size = st.st_size;
+  g.map = mmap(NULL, g.map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (g.map == MAP_FAILED) {
+    g.map = nullptr;
+    throw csr_error("Couldn't mmap file: ", path);
+  }
+  madvise(g.map, g.map_size, MADV_WILLNEED);
+
+  const csr_header *h = (const csr_header *)g.map;
+  if (memcmp(h->magic, CSR_MAGIC, sizeof(h->magic)) != 0 ||
+      h->version != CSR_VERSION)
+    throw csr_error("Unsupported CSR graph version: ", path);
+  g.nb_nodes = h->nb_nodes;
+  g.nb_edges = h->nb_edges;
+  size_t expected = sizeof(csr_header) + (g.nb_nodes + 1) * sizeof(uint64_t) +
+                    g.nb_edges * sizeof(csr_edge);
+  if (g.map_size != expected)
+    throw csr_error("Truncated CSR graph: ", path);
+  g.offsets = (const uint64_t *)(h + 1);
+  g.edges = (const csr_edge *)(g.offsets + g.nb_nodes + 1);
+  if (g.offsets[g.nb_nodes] != g.nb_edges)
+    throw csr_error("Corrupt CSR offsets: ", path);
+}
+
+/// Writes g in the binary format.
+inline void csr_write(const char *path, const csr_graph &g) {
+  FILE *f = fopen(path, "wb");
+  if (f == nullptr)
+    throw csr_error("Couldn't open file: ", path);
+  csr_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CSR_MAGIC, sizeof(CSR_MAGIC));
+  h.version = CSR_VERSION;
+  h.nb_nodes = g.nb_nodes;
+  h.nb_edges = g.nb_edges;
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+            fwrite(g.offsets, sizeof(uint64_t), g.nb_nodes + 1, f) ==
+                g.nb_nodes + 1 &&
+            fwrite(g.edges, sizeof(csr_edge), g.nb_edges, f) == g.nb_edges;
+  if (fclose(f) != 0 || !ok)
+    throw csr_error("Couldn't write CSR graph: ", path);
+}
+
+/// Fills g from edge lists split into chunks: edge i of chunk t goes from
+/// src[t][i] to edges[t][i].target. The sort by source is stable, so each
+/// node's edges keep chunk order. The chunks are freed as they are consumed.
+inline void csr_build(csr_graph &g, long long nb_nodes,
+                      std::vector<std::vector<int32_t>> &src,
+                      std::vector<std::vector<csr_edge>> &edges) {
+  g.own_offsets.assign(nb_nodes + 1, 0);
+  for (auto &chunk : src)
+    for (int32_t u : chunk)
+      g.own_offsets[u + 1]++;
+  for (long long u = 0; u < nb_nodes; ++u)
+    g.own_offsets[u + 1] += g.own_offsets[u];
+  uint64_t nb_edges = g.own_offsets[nb_nodes];
+  g.own_edges.resize(nb_edges);
+  std::vector<uint64_t> next(g.own_offsets.begin(), g.own_offsets.end() - 1);
+  for (size_t t = 0; t < src.size(); ++t) {
+    for (size_t i = 0; i < src[t].size(); ++i)
+      g.own_edges[next[src[t][i]]++] = edges[t][i];
+    std::vector<int32_t>().swap(src[t]);
+    std::vector<csr_edge>().swap(edges[t]);
+  }
+
+  g.nb_nodes = nb_nodes;
+  g.nb_edges = nb_edges;
+  g.offsets = g.own_offsets.data();
+  g.edges = g.own_edges.data();
+}
+
+// parses the edges of text[begin, end), which starts at a line start, keeping
+// those with both endpoints below nb_nodes (weights are filled in later)
+inline void csr_parse_chunk(const char *text, size_t begin, size_t end,
+                            long long nb_nodes, std::vector<int32_t> &src,
+                            std::vector<csr_edge> &dst) {
+  const char *p = text + begin;
+  const char *const e = text + end;
+  while (p < e) {
+    if (*p == '#') {
+      while (p < e && *p != '\n')
+        ++p;
+      ++p;
+      continue;
+    }
+    long long uv[2];
+    int found = 0;
+    while (found < 2 && p < e && *p != '\n') {
+      if (*p >= '0' && *p <= '9') {
+        long long x = 0;
+        while (p < e && *p >= '0' && *p <= '9')
+          x = x * 10 + (*p++ - '0');
+        uv[found++] = x;
+      } else {
+        ++p;
+      }
+    }
+    while (p < e && *p != '\n')
+      ++p;
+    ++p;
+    if (found == 2 && uv[0] < nb_nodes && uv[1] < nb_nodes) {
+      src.push_back((int32_t)uv[0]);
+      dst.push_back({(int32_t)uv[1], 0});
+    }
+  }
+}
+
+/// Parses a text edge list with nb_threads threads. If max_nodes is not -1,
+/// only the first max_nodes nodes (and the edges between them) are kept.
+/// weight_of() is called once per kept edge, in file order.
+template <typename Weight>
+void csr_parse_text(const char *path, int max_nodes, int nb_threads,
+                    csr_graph &g, Weight weight_of) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    throw csr_error("Couldn't open file: ", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw csr_error("Couldn't stat file: ", path);
+  }
+  size_t size = st.st_size;
+  void *map = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+  close(fd);
+  if (map == MAP_FAILED || map == nullptr)
+    throw csr_error("Couldn't mmap file: ", path);
+  madvise(map, size, MADV_SEQUENTIAL);
+  const char *text = (const char *)map;
+
+  uint64_t header_nodes, header_edges;
+  std::string first(text, strnlen(text, size < 256 ? size : 256));
+  if (sscanf(first.c_str(), "# Nodes: %" SCNu64 " Edges: %" SCNu64,
+             &header_nodes, &header_edges) != 2) {
+    munmap(map, size);
+    throw csr_error("Missing \"# Nodes: <n> Edges: <m>\" header: ", path);
+  }
+  long long nb_nodes = header_nodes;
+  if (max_nodes != -1 && nb_nodes > max_nodes)
+    nb_nodes = max_nodes;
+
+  // split the body into one chunk per thread, each starting at a line start
+  size_t body = first.find('\n');
+  body = (body == std::string::npos ? size : body + 1);
+  if (nb_threads < 1)
+    nb_threads = 1;
+  std::vector<size_t> bounds(nb_threads + 1, size);
+  bounds[0] = body;
+  for (int t = 1; t < nb_threads; ++t) {
+    size_t b = body + (size - body) / nb_threads * t;
+    if (b < bounds[t - 1])
+      b = bounds[t - 1];
+    while (b < size && text[b - 1] != '\n')
+      ++b;
+    bounds[t] = b;
+  }
+  std::vector<std::vector<int32_t>> src(nb_threads);
+  std::vector<std::vector<csr_edge>> dst(nb_threads);
+  std::vector<std::thread> parsers;
+  for (int t = 0; t < nb_threads; ++t)
+    parsers.emplace_back([&, t] {
+      csr_parse_chunk(text, bounds[t], bounds[t + 1], nb_nodes, src[t],
+                      dst[t]);
+    });
+  for (auto &p : parsers)
+    p.join();
+  munmap(map, size);
+
+  for (auto &chunk : dst)
+    for (csr_edge &e : chunk)
+      e.weight = weight_of();
+  csr_build(g, nb_nodes, src, dst);
+}
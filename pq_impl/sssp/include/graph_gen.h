@@ -0,0 +1,254 @@
+// synthetic graphs generated in parallel straight into a csr_graph, so scaling
+// runs need no input files
+//
+//   rmat:<scale>[:<edge factor>]  R-MAT (Kronecker) graph, 2^scale nodes and
+//                                 edge factor (default 16) * 2^scale undirected
+//                                 edges, with a=.57 b=.19 c=.19 as in Graph500;
+//                                 self loops are dropped and node ids permuted
+//   grid:<rows>[:<cols>]          road-like 2D grid, each node linked to its 4
+//                                 neighbours (cols defaults to rows)
+//   geo:<nodes>[:<avg degree>]    random geometric graph: points in the unit
+//                                 square, linked when closer than the radius
+//                                 giving avg degree (default 8) neighbours;
+//                                 nodes are numbered in spatial order
+//
+// Every undirected edge is stored in both directions with the same weight:
+// uniform in [1, max_weight] if max_weight > 1, else [20,30]U[70,80] if
+// bimodal, else 1. Geometric graphs default to their edge lengths scaled to
+// [1, 100] instead of 1. All draws hash (seed, edge) rather than sharing an
+// RNG, so the graph depends on the seed only, not on the number of threads.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "csr_graph.h"
+
+inline uint64_t gen_hash(uint64_t seed, uint64_t x) {
+  uint64_t z = seed + (x + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// uniform in [0, 1)
+inline double gen_unit(uint64_t h) { return (h >> 11) * (1.0 / (1ULL << 53)); }
+
+struct gen_weights {
+  int max_weight;
+  int bimodal;
+
+  bool random() const { return max_weight > 1 || bimodal; }
+  int32_t operator()(uint64_t h) const {
+    if (max_weight > 1)
+      return (int32_t)(h % max_weight) + 1;
+    if (bimodal)
+      return (int32_t)((h >> 1) % 11) + (h & 1 ? 20 : 70);
+    return 1;
+  }
+};
+
+// runs body(t, begin, end) on nb_threads threads over equal slices of [0, n)
+template <typename Body>
+void gen_parallel(uint64_t n, int nb_threads, Body body) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nb_threads; ++t)
+    workers.emplace_back(
+        [&, t] { body(t, n * t / nb_threads, n * (t + 1) / nb_threads); });
+  for (auto &w : workers)
+    w.join();
+}
+
+inline void gen_rmat(int scale, int edge_factor, uint64_t seed, int nb_threads,
+                     gen_weights weight, csr_graph &g) {
+  if (scale < 1 || scale > 30 || edge_factor < 1)
+    throw std::invalid_argument("rmat needs 1 <= scale <= 30 and a positive "
+                                "edge factor");
+  const uint64_t nodes = 1ULL << scale;
+  const uint64_t edges = nodes * edge_factor;
+  // a bijection on [0, nodes) so the high degree nodes are not all at low ids
+  const uint64_t mul = gen_hash(seed, ~0ULL) | 1;
+  const uint64_t add = gen_hash(seed, ~1ULL);
+  auto permute = [&](uint64_t v) { return (v * mul + add) & (nodes - 1); };
+
+  std::vector<std::vector<int32_t>> src(nb_threads);
+  std::vector<std::vector<csr_edge>> dst(nb_threads);
+  gen_parallel(edges, nb_threads, [&](int t, uint64_t begin, uint64_t end) {
+    src[t].reserve(2 * (end - begin));
+    dst[t].reserve(2 * (end - begin));
+    for (uint64_t e = begin; e < end; ++e) {
+      uint64_t h = gen_hash(seed, e);
+      uint64_t u = 0, v = 0;
+      for (int bit = 0; bit < scale; ++bit) {
+        double p = gen_unit(h);
+        h = gen_hash(h, bit);
+        u <<= 1;
+        v <<= 1;
+        if (p >= 0.57 + 0.19) // c or d
+          u |= 1;
+        if ((p >= 0.57 && p < 0.57 + 0.19) || p >= 0.57 + 0.19 + 0.19) // b or d
+          v |= 1;
+      }
+      if (u == v)
+        continue;
+      int32_t w = weight(h);
+      src[t].push_back((int32_t)permute(u));
+      dst[t].push_back({(int32_t)permute(v), w});
+      src[t].push_back((int32_t)permute(v));
+      dst[t].push_back({(int32_t)permute(u), w});
+    }
+  });
+  csr_build(g, nodes, src, dst);
+}
+
+inline void gen_grid(long long rows, long long cols, uint64_t seed,
+                     int nb_threads, gen_weights weight, csr_graph &g) {
+  if (rows < 1 || cols < 1 || rows * cols > INT32_MAX)
+    throw std::invalid_argument("grid needs 1 <= rows * cols < 2^31");
+  const uint64_t nodes = rows * cols;
+
+  // the edges right of and below node u have ids 2u and 2u + 1
+  std::vector<std::vector<int32_t>> src(nb_threads);
+  std::vector<std::vector<csr_edge>> dst(nb_threads);
+  gen_parallel(nodes, nb_threads, [&](int t, uint64_t begin, uint64_t end) {
+    src[t].reserve(4 * (end - begin));
+    dst[t].reserve(4 * (end - begin));
+    auto link = [&](uint64_t u, uint64_t v, uint64_t id) {
+      int32_t w = weight(gen_hash(seed, id));
+      src[t].push_back((int32_t)u);
+      dst[t].push_back({(int32_t)v, w});
+      src[t].push_back((int32_t)v);
+      dst[t].push_back({(int32_t)u, w});
+    };
+    for (uint64_t u = begin; u < end; ++u) {
+      if ((long long)(u % cols) + 1 < cols)
+        link(u, u + 1, 2 * u);
+      if ((long long)(u / cols) + 1 < rows)
+        link(u, u + cols, 2 * u + 1);
+    }
+  });
+  csr_build(g, nodes, src, dst);
+}
+
+inline void gen_geometric(long long nodes, double degree, uint64_t seed,
+                          int nb_threads, gen_weights weight, csr_graph &g) {
+  if (nodes < 1 || nodes > INT32_MAX || degree <= 0)
+    throw std::invalid_argument("geo needs 1 <= nodes < 2^31 and a positive "
+                                "average degree");
+  const double radius = std::min(1.0, sqrt(degree / (M_PI * nodes)));
+  const long long cells = std::max(1LL, (long long)(1 / radius));
+
+  // bucket the points by cell; a node's id is its position in cell order
+  auto cell_of = [&](double c) { return std::min(cells - 1, (long long)(c * cells)); };
+  std::vector<uint64_t> cell_start(cells * cells + 1, 0);
+  for (long long i = 0; i < nodes; ++i) {
+    double x = gen_unit(gen_hash(seed, 2 * i));
+    double y = gen_unit(gen_hash(seed, 2 * i + 1));
+    cell_start[cell_of(y) * cells + cell_of(x) + 1]++;
+  }
+  for (long long c = 0; c < cells * cells; ++c)
+    cell_start[c + 1] += cell_start[c];
+  std::vector<double> xs(nodes), ys(nodes);
+  std::vector<uint64_t> next(cell_start.begin(), cell_start.end() - 1);
+  for (long long i = 0; i < nodes; ++i) {
+    double x = gen_unit(gen_hash(seed, 2 * i));
+    double y = gen_unit(gen_hash(seed, 2 * i + 1));
+    uint64_t id = next[cell_of(y) * cells + cell_of(x)]++;
+    xs[id] = x;
+    ys[id] = y;
+  }
+
+  std::vector<std::vector<int32_t>> src(nb_threads);
+  std::vector<std::vector<csr_edge>> dst(nb_threads);
+  gen_parallel(nodes, nb_threads, [&](int t, uint64_t begin, uint64_t end) {
+    src[t].reserve((size_t)(degree * (end - begin) * 1.1));
+    dst[t].reserve((size_t)(degree * (end - begin) * 1.1));
+    for (uint64_t u = begin; u < end; ++u) {
+      long long cx = cell_of(xs[u]), cy = cell_of(ys[u]);
+      for (long long ny = std::max(0LL, cy - 1);
+           ny <= std::min(cells - 1, cy + 1); ++ny) {
+        for (long long nx = std::max(0LL, cx - 1);
+             nx <= std::min(cells - 1, cx + 1); ++nx) {
+          long long cell = ny * cells + nx;
+          for (uint64_t v = cell_start[cell]; v < cell_start[cell + 1]; ++v) {
+            double d = hypot(xs[u] - xs[v], ys[u] - ys[v]);
+            if (v == u || d > radius)
+              continue;
+            // both directions hash the same (smaller, larger) pair
+            uint64_t pair = std::min(u, v) * (uint64_t)nodes + std::max(u, v);
+            int32_t w = weight.random() ? weight(gen_hash(seed, ~pair))
+                                        : 1 + (int32_t)(d / radius * 99);
+            src[t].push_back((int32_t)u);
+            dst[t].push_back({(int32_t)v, w});
+          }
+        }
+      }
+    }
+  });
+  csr_build(g, nodes, src, dst);
+}
+
+// splits spec into its kind and its one or two numeric arguments
+inline std::string gen_parse(const char *spec, double args[2], int &nb_args) {
+  std::string kind(spec, strcspn(spec, ":"));
+  const char *p = spec + kind.size();
+  nb_args = 0;
+  while (*p == ':' && nb_args < 2) {
+    char *end;
+    args[nb_args++] = strtod(p + 1, &end);
+    if (end == p + 1)
+      break;
+    p = end;
+  }
+  if (*p != '\0' || nb_args == 0) {
+    std::string msg = "Invalid graph generator: ";
+    msg += spec;
+    throw std::invalid_argument(msg);
+  }
+  return kind;
+}
+
+/// True if spec generates a grid, whose node r * cols + c is at row r and
+/// column c.
+inline bool gen_grid_dims(const char *spec, long long &rows, long long &cols) {
+  double args[2];
+  int nb_args;
+  if (gen_parse(spec, args, nb_args) != "grid")
+    return false;
+  rows = (long long)args[0];
+  cols = (long long)args[nb_args - 1];
+  return true;
+}
+
+/// Generates the graph described by spec (see the top of this file).
+inline void gen_graph(const char *spec, uint64_t seed, int nb_threads,
+                      gen_weights weight, csr_graph &g) {
+  double args[2];
+  int nb_args;
+  std::string kind = gen_parse(spec, args, nb_args);
+  if (nb_threads < 1)
+    nb_threads = 1;
+
+  if (kind == "rmat")
+    gen_rmat((int)args[0], nb_args > 1 ? (int)args[1] : 16, seed, nb_threads,
+             weight, g);
+  else if (kind == "grid")
+    gen_grid((long long)args[0], (long long)args[nb_args - 1], seed,
+             nb_threads, weight, g);
+  else if (kind == "geo")
+    gen_geometric((long long)args[0], nb_args > 1 ? args[1] : 8, seed,
+                  nb_threads, weight, g);
+  else {
+    std::string msg = "Unknown graph generator: ";
+    msg += kind;
+    throw std::invalid_argument(msg);
+  }
+}
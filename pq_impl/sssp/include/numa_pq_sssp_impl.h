@@ -8,4 +8,8 @@ inline void numa_pq_remove(numa_pq_t *pq, long unsigned *key, long unsigned *val
 
 inline void numa_pq_insert(numa_pq_t *pq, long key, long val) {
     pq->hier_insert_local(key, val);
+}
+
+inline void numa_pq_insert_batch(numa_pq_t *pq, const numa_pq_t::PQ_Node *elems, int n) {
+    pq->hier_insert_batch(elems, n);
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+// a monotone radix heap and the sequential Dijkstra built on it, the oracle
+// the parallel runs are checked against (-V)
+//
+// A radix heap (Ahuja, Mehlhorn, Orlin and Tarjan) only supports keys that are
+// never smaller than the last one popped, which Dijkstra guarantees. Bucket 0
+// holds the keys equal to last; bucket i > 0 the keys whose highest bit
+// differing from last is bit i - 1. A pop empties bucket 0 first; otherwise it
+// takes the first non-empty bucket, makes its minimum the new last and
+// redistributes the bucket into lower ones. Each element moves down at most 64
+// times, and a pop never compares against more than one bucket's elements.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+
+struct radix_heap {
+  std::vector<std::pair<uint64_t, int32_t>> buckets[65];
+  uint64_t last = 0;
+  size_t size = 0;
+
+  static int bucket_of(uint64_t key, uint64_t last) {
+    return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+  }
+
+  bool empty() const { return size == 0; }
+
+  void push(uint64_t key, int32_t value) {
+    buckets[bucket_of(key, last)].push_back({key, value});
+    size++;
+  }
+
+  std::pair<uint64_t, int32_t> pop() {
+    if (buckets[0].empty()) {
+      int i = 1;
+      while (buckets[i].empty())
+        i++;
+      last = std::min_element(buckets[i].begin(), buckets[i].end())->first;
+      for (const auto &elem : buckets[i])
+        buckets[bucket_of(elem.first, last)].push_back(elem);
+      buckets[i].clear();
+    }
+    std::pair<uint64_t, int32_t> top = buckets[0].back();
+    buckets[0].pop_back();
+    size--;
+    return top;
+  }
+};
+
+// the work a sequential run does, the baseline for the parallel runs' work
+struct dijkstra_work {
+  uint64_t pops = 0;        // including the superseded (stale) ones
+  uint64_t settled = 0;     // nodes reached, each relaxed once
+  uint64_t relaxations = 0; // edges scanned
+  uint64_t inserts = 0;     // including the source
+};
+
+/// Sequential Dijkstra from src; unreachable nodes get distance (uint64_t)-1.
+/// If work is not null, the run's work is counted into it.
+inline void radix_dijkstra(const csr_graph &g, int src,
+                           std::vector<uint64_t> &dist,
+                           dijkstra_work *work = nullptr) {
+  dijkstra_work count;
+  dist.assign(g.nb_nodes, (uint64_t)-1);
+  radix_heap heap;
+  dist[src] = 0;
+  heap.push(0, src);
+  count.inserts++;
+  while (!heap.empty()) {
+    auto [key, u] = heap.pop();
+    count.pops++;
+    if (key != dist[u])
+      continue; // superseded by a shorter path
+    count.settled++;
+    const csr_edge *const end = g.edges + g.offsets[u + 1];
+    count.relaxations += end - (g.edges + g.offsets[u]);
+    for (const csr_edge *e = g.edges + g.offsets[u]; e < end; e++) {
+      uint64_t newdist = key + e->weight;
+      if (newdist < dist[e->target]) {
+        dist[e->target] = newdist;
+        heap.push(newdist, e->target);
+        count.inserts++;
+      }
+    }
+  }
+  if (work != nullptr)
+    *work = count;
+}
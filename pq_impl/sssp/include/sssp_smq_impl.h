@@ -11,4 +11,8 @@ inline long smq_remove(smq_t *pq, unsigned long* key) {
 
 inline void smq_insert(smq_t *pq, long key, long val) {
     pq->push(std::make_pair(key, val));
+}
+
+inline void smq_insert_batch(smq_t *pq, const std::pair<long,long> *elems, int n) {
+    pq->push(elems, n);
 }
\ No newline at end of file
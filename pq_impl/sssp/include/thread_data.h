@@ -33,7 +33,8 @@ enum DataStructure {
   // SV_TEAMS,
   NUMA_PQ,
   NUMA_PQ_4,
-  SMQ
+  SMQ,
+  DELTA // delta-stepping, the bucket-based baseline (no priority queue)
 };
 
 // NB: in test.cc, there are if/else chains that don't afford clean errors when
@@ -56,6 +57,8 @@ inline const char *to_string(DataStructure ds) {
     return "Numa-PQ-4";
   case SMQ:
     return "SMQ";
+  case DELTA:
+    return "Delta-stepping";
   default:
     std::string msg = "Invalid data structure: ";
     msg += std::to_string(ds);
@@ -82,6 +85,10 @@ struct ALIGNED(64) thread_data_t {
   unsigned long nb_removals;
   unsigned long nb_removed;
   unsigned long nb_dead_nodes;
+  unsigned long nb_reprocessed; // alive pops of a node already relaxed before
+  unsigned long nb_relaxations; // edges scanned
+  unsigned long nb_redundant;   // inserts of a node already in the queue
+  unsigned long tree_weight; // prim: weight of the edges this thread added
   unsigned long nb_contains;
   unsigned long nb_found;
   unsigned long nb_aborts;
@@ -35,6 +35,18 @@
 
 # obj64/sssp -i inputs/twitter_rv.txt -o out.txt -t 96 -D linden -x 20 -z 35
 
+# generated graphs need no input files (see include/graph_gen.h)
+#obj64/sssp -G rmat:22 -o out.txt -t 96 -D numa_pq_lin -w 100
+#obj64/sssp -G grid:4000 -o out.txt -t 96 -D linden -w 100
+#obj64/sssp -G geo:10000000 -o out.txt -t 96 -D numa_pq_lin -x 20 -z 35
+
+# delta-stepping baseline (-d sets the bucket width, default max weight / avg degree)
+#obj64/sssp -G rmat:22 -o out.txt -t 96 -D delta -w 100
+
+# A* and Prim over the same queues (both check themselves against a sequential run)
+#obj64/sssp -A astar -G grid:4000 -t 96 -D numa_pq_lin -w 100
+#obj64/sssp -A prim -G geo:10000000 -t 96 -D numa_pq_lin
+
 
 # if [ -z $1 ]
 # then
@@ -125,3 +137,12 @@ done
 done
 
 
+
+# a stream of 1000 queries from random sources on one loaded graph (latency percentiles in the JSON)
+#obj64/sssp -Q 1000 -G grid:4000 -t 96 -D numa_pq_lin -w 100 -j results.json
+
+# check the distances against a sequential radix heap Dijkstra (no reference file needed)
+#obj64/sssp -G rmat:22 -t 96 -D numa_pq_lin -w 100 -V
+
+# work efficiency: useful vs wasted pops relative to the sequential Dijkstra (-V), per 100 ms interval (-W)
+#obj64/sssp -G rmat:22 -t 96 -D smq -w 100 -V -W 100 -j results.json
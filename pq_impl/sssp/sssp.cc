@@ -10,12 +10,22 @@
 
 #include "math.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
 #include <exception>
 #include <iostream>
+#include <queue>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "../common/static_initialization.h"
+#include "../common/json_results.h"
+#include "../common/pq_trace.h"
+#include "../common/rank_error.h"
 #include "include/numa_pq_sssp_impl.h"
 #include "include/numa_pq_4leaders_sssp_impl.h"
 #include "include/sssp_smq_impl.h"
@@ -25,6 +35,9 @@
 // #include "include/sv_lin_impl.h"
 // #include "include/sv_teams_impl.h"
 #include "include/thread_data.h"
+#include "include/csr_graph.h"
+#include "include/graph_gen.h"
+#include "include/radix_heap.h"
 
 
 #define MAX_DEPS 10
@@ -36,27 +49,27 @@ __thread unsigned long *seeds;
 
 ALIGNED(64) uint8_t running[64];
 
-typedef struct graph_node_s {
-  int deg;
-  slkey_t dist;
-  int *adj;
-  int *weights;
-  int times_processed;
-} graph_node_t;
-
 // for CBPQ
 #ifdef CBPQ
 __thread unsigned long nextr = 1;
 #endif
 
-graph_node_t *nodes;
+// the graph is read-only CSR; the per-node state lives in separate arrays so a
+// relaxation reads one edge stream and only writes dist (interleaved over the
+// NUMA nodes, since every thread CASes into all of it)
+csr_graph graph;
+slkey_t *dist;
+int *times_processed;
+
+inline int degree(int u) { return graph.offsets[u + 1] - graph.offsets[u]; }
 
 sl_intset_t *set_ds;
 pq_t *linden_set;
 numa_pq_t *numa_pq_ds;
 numa_pq_4_t *numa_pq_4_ds;
 smq_t *smq_ds;
-int i, c, nb_nodes, nb_edges;
+int i, c;
+uint64_t nb_nodes, nb_edges;
 unsigned long effreads, updates, effupds, nb_insertions, nb_nontail_insertions,
     nb_removals, nb_removed, nb_dead_nodes;
 thread_data_t *thread_data;
@@ -68,12 +81,32 @@ int nb_threads = DEFAULT_NB_THREADS;
 int seed = DEFAULT_SEED;
 DataStructure ds = UNKNOWN;
 const char *input = "";
+const char *generator = "";
 const char *output = "";
 const char *verify_file = "";
+bool dijkstra_check = false;
+long dijkstra_mismatches = 0;
+double dijkstra_ms = 0, dijkstra_compare_ms = 0;
+dijkstra_work sequential_work;
 const char *reduced_file = "";
+const char *json_output = "";
+const char *csr_output = "";
+const char *trace_file = "";
+pq_trace_recorder *trace_recorder = NULL;
+bool rank_error = false;
+rank_error_stats rank_stats;
+const char *verify_status = "not_run";
 int src = -1;
 int max_levels = -1;
 int max_weight = 0;
+bool batch_relax = false;
+int nb_queries = 0;
+// -Q: per thread, the nodes whose dist the current query set, so the next
+// query resets only those; query_ms holds each query's latency and
+// query_sources each query's source
+std::vector<int> *dirty = nullptr;
+std::vector<double> query_ms;
+std::vector<int> query_sources;
 int bimodal = 0;
 bool output_csv = false;
 int size_histogram_granularity = 0;
@@ -84,6 +117,112 @@ slkey_t max_inserted_key;
 size_t *key_histogram;
 size_t key_histogram_size = 0;
 
+// Termination detection. Every queue element is counted as pending from just
+// before its insert until the thread that pops it has relaxed its edges, so
+// nothing is in the queue or being relaxed exactly when the pending count is
+// zero. Each thread counts its own pushes and finishes; the counters only grow,
+// so two identical collects of all of them are a consistent snapshot. A
+// (key, node) pair is inserted at most once (dist only decreases), so no queue
+// drops an element as a duplicate and leaves it pending forever.
+struct alignas(64) pending_counts {
+  std::atomic<unsigned long> pushed;
+  std::atomic<unsigned long> finished;
+};
+pending_counts *pending;
+std::atomic<bool> sssp_done(false);
+
+inline void count_push(int tid) { pending[tid].pushed.fetch_add(1); }
+inline void count_finish(int tid) { pending[tid].finished.fetch_add(1); }
+
+bool quiescent() {
+  unsigned long first[2 * nb_threads];
+  long balance = 0;
+  for (int t = 0; t < nb_threads; t++) {
+    first[2 * t] = pending[t].pushed.load();
+    first[2 * t + 1] = pending[t].finished.load();
+    balance += first[2 * t] - first[2 * t + 1];
+  }
+  if (balance != 0)
+    return false;
+  for (int t = 0; t < nb_threads; t++) {
+    if (pending[t].pushed.load() != first[2 * t] ||
+        pending[t].finished.load() != first[2 * t + 1])
+      return false;
+  }
+  return true;
+}
+
+// -W: the run's work per interval of this many ms. Each thread counts into its
+// own vector and main merges them at the end. A thread reads the clock (and
+// grows its vector) only every WORK_CLOCK_RECORDS records, so a record can
+// land in the interval before its own; the vectors are reserved for
+// WORK_TIMELINE_RESERVE intervals so that growing them rarely reallocates.
+#define WORK_CLOCK_RECORDS 64
+#define WORK_TIMELINE_RESERVE 1024
+struct work_interval {
+  unsigned long alive, dead, empty, reprocessed, inserts, redundant;
+};
+struct alignas(64) work_thread_timeline {
+  std::vector<work_interval> intervals;
+  size_t ix = 0;       // interval the thread is counting into
+  int until_clock = 0; // records before the clock is read again
+};
+int work_interval_ms = 0;
+work_thread_timeline *work_timeline = nullptr;
+std::chrono::steady_clock::time_point work_start;
+
+inline void work_record(int tid, unsigned long work_interval::*counter) {
+  if (work_timeline == nullptr)
+    return;
+  work_thread_timeline &w = work_timeline[tid];
+  if (--w.until_clock < 0) {
+    w.until_clock = WORK_CLOCK_RECORDS;
+    w.ix = std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - work_start)
+               .count() /
+           work_interval_ms;
+    if (w.intervals.size() <= w.ix)
+      w.intervals.resize(w.ix + 1, work_interval());
+  }
+  w.intervals[w.ix].*counter += 1;
+}
+
+// The application run over the queue. A* searches from src to target on a
+// generated grid, keyed by distance plus min edge weight times the Manhattan
+// distance to target (consistent, so a node's first live pop is final as in
+// Dijkstra); pops whose key is no better than the best path found to target
+// are pruned. Prim grows a spanning tree from src keyed by the weight of the
+// edge into the tree, which is not monotone; a node joins the tree when its
+// first live pop claims it in times_processed. Concurrent claims can pick an
+// edge that a later tree node would beat, so with several threads the tree
+// can be heavier than a minimum one; the excess is reported.
+enum Application { APP_SSSP, APP_ASTAR, APP_PRIM };
+Application app = APP_SSSP;
+int target = -1;
+long long grid_cols;
+slkey_t min_edge_weight;
+slkey_t app_result, app_reference; // path length or tree weight, and a
+                                   // sequential run's
+
+inline const char *to_string(Application a) {
+  return a == APP_ASTAR ? "astar" : a == APP_PRIM ? "prim" : "sssp";
+}
+
+// the part of a queue key that is not the node's dist
+inline slkey_t heuristic(int v) {
+  if (app != APP_ASTAR)
+    return 0;
+  long long dr = v / grid_cols - target / grid_cols;
+  long long dc = v % grid_cols - target % grid_cols;
+  return min_edge_weight * (llabs(dr) + llabs(dc));
+}
+
+// whether a popped key can no longer lead to a shorter path to target
+inline bool astar_pruned(slkey_t key) {
+  slkey_t best = dist[target];
+  return best != (slkey_t)-1 && key >= best;
+}
+
 void barrier_init(barrier_t *b, int n) {
   pthread_cond_init(&b->complete, NULL);
   pthread_mutex_init(&b->mutex, NULL);
@@ -107,44 +246,34 @@ void barrier_cross(barrier_t *b) {
   pthread_mutex_unlock(&b->mutex);
 }
 
-void *sssp(void *thread_data) {
-  thread_data_t *d = (thread_data_t *)thread_data;
-  int const early_break_threshold = 16 * (int)d->nb_threads;
-
-  /* Create transaction */
-  // set_cpu(the_cores[d->id]);
-  thread_context::create_context(d->id, cpu_policy::FILL_ONE_HYPERTHREAD_LAST);
-  /* Wait on barrier */
-  ssalloc_init();
-
-  seeds = seed_rand();
-
-  if (d->ds == NUMA_PQ) { // perform thread-inits
-    d->numa_pq_ds->threadInit(d->id);
-    if (d->id == 0) { // have one thread perform the initial insert
-      slkey_t start_key = 0;
-      numa_pq_insert(numa_pq_ds, start_key, src); // initial insert
-    }
+/// Inserts the source into the queues whose inserts need the context of a
+/// worker thread (the others are seeded by insert_source).
+void insert_source_local(thread_data_t *d) {
+  slkey_t start_key = heuristic(src);
+  if (d->ds == NUMA_PQ) {
+    numa_pq_insert(numa_pq_ds, start_key, src);
   } else if (d->ds == NUMA_PQ_4) {
-    d->numa_pq_4_ds->threadInit(d->id);
-    if (d->id == 0) { // have one thread perform the initial insert // todo: try with only one thread inserting source ??
-      slkey_t start_key = 0;
-      numa_pq_4_insert(numa_pq_4_ds, start_key, src); // initial insert
-    }
+    numa_pq_4_insert(numa_pq_4_ds, start_key, src);
   } else if (d->ds == SMQ) {
-    d->smq_ds->initThread(d->id);
-    if (d->id == 0) {
-      std::cout << "inserting source!\n";
-      slkey_t start_key = 0;
-      smq_insert(smq_ds, start_key, src); // initial insert
-    }
+    std::cout << "inserting source!\n";
+    smq_insert(smq_ds, start_key, src);
+  } else {
+    return;
   }
+  if (trace_recorder)
+    trace_recorder->record(d->id, PQ_TRACE_INSERT, start_key, src);
+}
 
-  barrier_cross(d->barrier);
+/// Runs one query: pops and relaxes until the queue is drained everywhere.
+void sssp_query(thread_data_t *d) {
+  // -B: the improved neighbours of a node are buffered and inserted with one
+  // batched call after its whole adjacency list is relaxed
+  std::vector<numa_pq_t::PQ_Node> pipq_batch;
+  std::vector<std::pair<long, long>> smq_batch;
 
   // Begin SSSP
 
-  int fail = 0;
+  int backoff = 1;
   int cnt = 0;
   //printf("op#: %d\n", cnt);
   while (1) {
@@ -158,6 +287,7 @@ void *sssp(void *thread_data) {
     //cnt++;
 
     ++d->nb_removals;
+    uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
     if (d->ds == SPRAY) {
       spray_delete_min_key(d->set, &node_distance, &node, d);
     } else if (d->ds == LOTAN) {
@@ -175,40 +305,52 @@ void *sssp(void *thread_data) {
       printf("error: no queue selected\n");
       exit(1);
     }
+    if (trace_recorder)
+      trace_recorder->record(d->id, PQ_TRACE_DELETE_MIN, node_distance, node, invoke);
 
     // todo: check diff here between matthew's impl and og spraylist to better understand what he means below
     if (node_distance == (slkey_t)-1) {
-      // list is empty; TODO make sure threads don't quit early
-      fail++;
-      // TODO: really need a better break condition...
-
-      // [mar] This is still a suboptimal break condition, but it should make
-      // the worst behavior much less likely. If this thread has never
-      // extracted, and there are "enough" total nodes that it's unlikely that
-      // the algorithm will complete before that happens, try harder.
-
-      int break_multiplier = 20;
-
-      if (d->nb_removed == 0 && nb_nodes > early_break_threshold) {
-        break_multiplier = 200;
-      }
-
-      if (fail > (int)(break_multiplier * d->nb_threads)) {
-        //std::cout << d->id << ": breaking...\n";
+      // the queue looked empty: done once nothing is pending anywhere, else
+      // back off while the elements still being relaxed get inserted
+      work_record(d->id, &work_interval::empty);
+      if (sssp_done.load(std::memory_order_relaxed))
+        break;
+      if (quiescent()) {
+        sssp_done.store(true);
         break;
       }
+      for (int j = 0; j < backoff; j++)
+        PAUSE;
+      if (backoff < 1024)
+        backoff *= 2;
+      else
+        sched_yield(); // in case the threads relaxing are not running
       continue;
     }
-    fail = 0;
-
-    if (node_distance != nodes[node].dist) {
-      //printf("node_distance = %ld, nodes[node].dist = %ld\n", node_distance, nodes[node].dist);
+    backoff = 1;
+
+    slkey_t node_dist = node_distance - heuristic(node);
+    if (node_dist != dist[node] ||
+        (app == APP_ASTAR && astar_pruned(node_distance)) ||
+        (app == APP_PRIM &&
+         !__sync_bool_compare_and_swap(&times_processed[node], 0, 1))) {
+      //printf("node_distance = %ld, dist[node] = %ld\n", node_distance, dist[node]);
       ++d->nb_dead_nodes;
+      work_record(d->id, &work_interval::dead);
+      count_finish(d->id);
       continue; // dead node
     }
 
-    nodes[node].times_processed++;
+    if (app == APP_PRIM) {
+      if (node != (val_t)src)
+        d->tree_weight += node_distance;
+    } else if (times_processed[node]++ > 0) {
+      // relaxed again with a shorter distance found since
+      ++d->nb_reprocessed;
+      work_record(d->id, &work_interval::reprocessed);
+    }
     ++d->nb_removed;
+    work_record(d->id, &work_interval::alive);
 
     if (size_histogram_granularity > 0 &&
         d->nb_removed % size_histogram_granularity == 0) {
@@ -218,17 +360,36 @@ void *sssp(void *thread_data) {
              node_distance);
     }
 
-    for (int i = 0; i < nodes[node].deg; i++) {
-      int v = nodes[node].adj[i];
-      int w = nodes[node].weights[i];
-      slkey_t dist_v = nodes[v].dist;
+    const csr_edge *const end = graph.edges + graph.offsets[node + 1];
+    d->nb_relaxations += degree(node);
+    for (const csr_edge *e = graph.edges + graph.offsets[node]; e < end; e++) {
+      int v = e->target;
+      int w = e->weight;
+      if (app == APP_PRIM && times_processed[v])
+        continue; // already in the tree
+      slkey_t dist_v = dist[v];
       // printf("v=%d dist_v=%d\n", v, dist_v);
-      slkey_t newkey = node_distance + w;
-      if (dist_v == (slkey_t)-1 || newkey < dist_v) {
+      slkey_t newdist = (app == APP_PRIM ? w : node_dist + w);
+      if (dist_v == (slkey_t)-1 || newdist < dist_v) {
         // found better path to v
-        int res = ATOMIC_CAS_MB(&nodes[v].dist, dist_v, newkey);
+        int res = ATOMIC_CAS_MB(&dist[v], dist_v, newdist);
         if (res) {
-          if (d->ds == LOTAN || d->ds == SPRAY) {
+          if (dist_v != (slkey_t)-1) {
+            // v's earlier entry is now dead
+            ++d->nb_redundant;
+            work_record(d->id, &work_interval::redundant);
+          } else if (dirty) {
+            dirty[d->id].push_back(v);
+          }
+          work_record(d->id, &work_interval::inserts);
+          slkey_t newkey = newdist + heuristic(v);
+          uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
+          count_push(d->id);
+          if (batch_relax && d->ds == NUMA_PQ) {
+            pipq_batch.push_back({(int)newkey, (long unsigned)v});
+          } else if (batch_relax && d->ds == SMQ) {
+            smq_batch.push_back(std::make_pair((long)newkey, (long)v));
+          } else if (d->ds == LOTAN || d->ds == SPRAY) {
             // add to queue only if CAS is successful
             sl_add_val(d->set, newkey, v, TRANSACTIONAL);
           } else if (d->ds == LINDEN) {
@@ -246,6 +407,8 @@ void *sssp(void *thread_data) {
             throw std::invalid_argument(msg);
           }
           d->nb_insertions++;
+          if (trace_recorder && !batch_relax)
+            trace_recorder->record(d->id, PQ_TRACE_INSERT, newkey, v, invoke);
 
           // Calculate stats for single-thread-only case
           if (nb_threads == 1) {
@@ -262,10 +425,59 @@ void *sssp(void *thread_data) {
             }
           }
         } else {
-          i--; // retry
+          e--; // retry
         }
       }
     }
+    if (!pipq_batch.empty()) {
+      uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
+      numa_pq_insert_batch(d->numa_pq_ds, pipq_batch.data(), pipq_batch.size());
+      if (trace_recorder)
+        for (const auto &elem : pipq_batch)
+          trace_recorder->record(d->id, PQ_TRACE_INSERT, elem.key, elem.value,
+                                 invoke);
+      pipq_batch.clear();
+    } else if (!smq_batch.empty()) {
+      uint64_t invoke = (trace_recorder ? trace_recorder->now() : 0);
+      smq_insert_batch(d->smq_ds, smq_batch.data(), smq_batch.size());
+      if (trace_recorder)
+        for (const auto &elem : smq_batch)
+          trace_recorder->record(d->id, PQ_TRACE_INSERT, elem.first,
+                                 elem.second, invoke);
+      smq_batch.clear();
+    }
+    count_finish(d->id);
+  }
+}
+
+void *sssp(void *thread_data) {
+  thread_data_t *d = (thread_data_t *)thread_data;
+
+  /* Create transaction */
+  // set_cpu(the_cores[d->id]);
+  thread_context::create_context(d->id, cpu_policy::FILL_ONE_HYPERTHREAD_LAST);
+  /* Wait on barrier */
+  ssalloc_init();
+
+  seeds = seed_rand();
+
+  if (d->ds == NUMA_PQ) { // perform thread-inits
+    d->numa_pq_ds->threadInit(d->id);
+  } else if (d->ds == NUMA_PQ_4) {
+    d->numa_pq_4_ds->threadInit(d->id);
+  } else if (d->ds == SMQ) {
+    d->smq_ds->initThread(d->id);
+  }
+
+  for (int query = 0; query < std::max(nb_queries, 1); query++) {
+    if (query > 0)
+      barrier_cross(d->barrier); // main has reset the previous query's state
+    if (d->id == 0) // have one thread perform the initial insert
+      insert_source_local(d);
+    barrier_cross(d->barrier);
+    sssp_query(d);
+    if (nb_queries > 0)
+      barrier_cross(d->barrier); // main times the query
   }
 
   // End SSSP
@@ -274,6 +486,161 @@ void *sssp(void *thread_data) {
   //return NULL;
 }
 
+
+// Delta-stepping (Meyer and Sanders), the bucket-based baseline for the
+// queues. Bucket b holds the (key, node) pairs with key / delta == b. Each
+// thread keeps its own buckets, in a ring of slots that covers every bucket a
+// relaxation can reach from the current one. A round settles the smallest
+// non-empty bucket: the threads pool their part of it into a shared frontier
+// and relax the light edges (weight <= delta) of its live nodes, which can
+// refill the bucket, until it stays empty; then each thread relaxes the heavy
+// edges of the nodes it settled, which only reach later buckets. Like the
+// queues, a pair whose key is no longer dist[node] is dead and skipped.
+struct delta_entry {
+  slkey_t key;
+  int node;
+};
+
+// a spinning barrier: the rounds cross several per bucket
+struct delta_barrier_t {
+  std::atomic<int> waiting{0};
+  std::atomic<unsigned> phase{0};
+};
+
+slkey_t delta = 0; // bucket width, 0 picks max weight / average degree
+slkey_t max_edge_weight;
+delta_barrier_t delta_barrier;
+std::vector<delta_entry> frontier;
+size_t *frontier_offsets; // each thread's share, then where it starts
+size_t frontier_size;
+std::atomic<size_t> frontier_next;
+std::atomic<uint64_t> next_bucket[2]; // alternate rounds, so one can be reset
+
+void delta_barrier_cross() {
+  unsigned phase = delta_barrier.phase.load();
+  if (delta_barrier.waiting.fetch_add(1) + 1 == nb_threads) {
+    delta_barrier.waiting.store(0);
+    delta_barrier.phase.fetch_add(1);
+    return;
+  }
+  int backoff = 1;
+  while (delta_barrier.phase.load() == phase) {
+    for (int j = 0; j < backoff; j++)
+      PAUSE;
+    if (backoff < 1024)
+      backoff *= 2;
+    else
+      sched_yield();
+  }
+}
+
+// relaxes the light or the heavy edges of node, whose distance was key
+void delta_relax(thread_data_t *d, std::vector<std::vector<delta_entry>> &bins,
+                 slkey_t key, int node, bool light) {
+  const csr_edge *const end = graph.edges + graph.offsets[node + 1];
+  for (const csr_edge *e = graph.edges + graph.offsets[node]; e < end; e++) {
+    if (((slkey_t)e->weight <= delta) != light)
+      continue;
+    int v = e->target;
+    slkey_t dist_v = dist[v];
+    slkey_t newkey = key + e->weight;
+    if (dist_v == (slkey_t)-1 || newkey < dist_v) {
+      if (ATOMIC_CAS_MB(&dist[v], dist_v, newkey)) {
+        bins[newkey / delta % bins.size()].push_back({newkey, v});
+        d->nb_insertions++;
+      } else {
+        e--; // retry
+      }
+    }
+  }
+}
+
+void *delta_stepping(void *thread_data) {
+  thread_data_t *d = (thread_data_t *)thread_data;
+  thread_context::create_context(d->id, cpu_policy::FILL_ONE_HYPERTHREAD_LAST);
+
+  // the pairs pending at any time lie within (max weight + delta) of the
+  // current bucket's start, i.e. in at most max weight / delta + 2 buckets
+  std::vector<std::vector<delta_entry>> bins(max_edge_weight / delta + 2);
+  std::vector<delta_entry> settled;
+  if (d->id == 0)
+    bins[0].push_back({0, src});
+
+  barrier_cross(d->barrier);
+
+  uint64_t bucket = 0;
+  for (unsigned round = 0;; round++) {
+    std::vector<delta_entry> &bin = bins[bucket % bins.size()];
+    while (1) {
+      // pool this bucket's pairs from all threads into the frontier
+      frontier_offsets[d->id] = bin.size();
+      delta_barrier_cross();
+      if (d->id == 0) {
+        size_t total = 0;
+        for (int t = 0; t < nb_threads; t++) {
+          size_t share = frontier_offsets[t];
+          frontier_offsets[t] = total;
+          total += share;
+        }
+        if (frontier.size() < total)
+          frontier.resize(total);
+        frontier_size = total;
+        frontier_next.store(0);
+      }
+      delta_barrier_cross();
+      std::copy(bin.begin(), bin.end(),
+                frontier.begin() + frontier_offsets[d->id]);
+      bin.clear();
+      delta_barrier_cross();
+      if (frontier_size == 0)
+        break;
+
+      const size_t chunk = 64;
+      size_t begin;
+      while ((begin = frontier_next.fetch_add(chunk)) < frontier_size) {
+        size_t end = std::min(begin + chunk, frontier_size);
+        for (size_t i = begin; i < end; i++) {
+          delta_entry entry = frontier[i];
+          ++d->nb_removals;
+          if (entry.key != dist[entry.node]) {
+            ++d->nb_dead_nodes;
+            continue;
+          }
+          times_processed[entry.node]++;
+          ++d->nb_removed;
+          delta_relax(d, bins, entry.key, entry.node, true);
+          settled.push_back(entry);
+        }
+      }
+    }
+
+    for (const delta_entry &entry : settled)
+      if (entry.key == dist[entry.node])
+        delta_relax(d, bins, entry.key, entry.node, false);
+    settled.clear();
+
+    uint64_t next = (uint64_t)-1;
+    for (uint64_t b = bucket + 1; b < bucket + bins.size(); b++) {
+      if (!bins[b % bins.size()].empty()) {
+        next = b;
+        break;
+      }
+    }
+    std::atomic<uint64_t> &shared = next_bucket[round & 1];
+    uint64_t seen = shared.load();
+    while (next < seen && !shared.compare_exchange_weak(seen, next))
+      ;
+    delta_barrier_cross();
+    bucket = shared.load();
+    if (bucket == (uint64_t)-1)
+      break;
+    if (d->id == 0) // nobody reads it again before the next round's barriers
+      next_bucket[(round + 1) & 1].store((uint64_t)-1);
+  }
+
+  pthread_exit(NULL);
+}
+
 void catcher(int sig) { printf("CAUGHT SIGNAL %d\n", sig); }
 
 void help() {
@@ -292,14 +659,50 @@ void help() {
        << "        lotan_shavit   = Lotan-Shavit Priority Queue" << endl
        << "        linden         = Linden Priority Queue" << endl
        << "        numa_pq_lin    = Numa-aware priority queue" << endl
+       << "        delta          = Delta-stepping (no queue; see -d)" << endl
+       << endl
+       << "  -d  Delta-stepping bucket width" << endl
+       << "        <int> (default=0 meaning max weight / average degree)"
+       << endl
+       << "  -A  application run over the queue" << endl
+       << "        sssp           = single source shortest paths (default)"
        << endl
+       << "        astar          = A* from -u to -U on a -G grid graph" << endl
+       << "        prim           = Prim spanning tree from -u (undirected "
+          "graphs)"
+       << endl
+       << "  -U  A* target node (default: the last node)" << endl
        << "  -t  Number of threads" << endl
        << "        <int> (default=" << DEFAULT_NB_THREADS << ")" << endl
        << "  -s  RNG seed" << endl
        << "        <int> (0=time-based, default=" << DEFAULT_SEED << ")" << endl
-       << "  -i  file to read the graph from (required) " << endl
+       << "  -i  file to read the graph from (unless -G): a text edge list, "
+          "or a binary CSR graph written by -C" << endl
+       << "  -G  generate the graph instead of reading it:" << endl
+       << "        rmat:<scale>[:<edge factor>=16]  R-MAT, 2^scale nodes" << endl
+       << "        grid:<rows>[:<cols>=rows]        2D grid, 4 neighbours"
+       << endl
+       << "        geo:<nodes>[:<avg degree>=8]     random geometric graph, "
+          "weighted by edge length unless -w/-b"
+       << endl
+       << "  -C  write the input or generated graph (with the weights chosen by "
+          "-w/-b/-s) as a binary CSR graph at this path and exit"
+       << endl
        << "  -o  file to write the resulting shortest paths to" << endl
        << "  -v  file to verify results against" << endl
+       << "  -V  verify results against a sequential (radix heap) Dijkstra"
+       << endl
+       << "      and compare the queue's work with the Dijkstra's" << endl
+       << "  -W  also count the work per interval of this many ms" << endl
+       << "  -j  append a JSON record of the configuration and results to "
+          "this file"
+       << endl
+       << "  -T  record the priority queue operations to this trace file "
+          "(replay with the microbenchmark's -b 17)"
+       << endl
+       << "  -e  report the rank error and delay of the delete-mins "
+          "(traces the run in memory)"
+       << endl
        << "  -m  if input graph exceeds max-graph-size, use first "
           "max-graph-size nodes"
        << endl
@@ -309,6 +712,15 @@ void help() {
        << "  -b  use random edge weights chosen in [20,30]U[70,80]; fixed"
        << endl
        << "      between trials given fixed seed" << endl
+       << "  -B  insert the improved neighbours of a node with one batched "
+          "call (numa_pq_lin, smq)"
+       << endl
+       << "  -Q  run this many SSSP queries on the loaded graph, reusing the "
+          "queue; the"
+       << endl
+       << "      first starts at -u, the rest at random nodes, and -o / -v "
+          "apply to the last"
+       << endl
        << "  -c  output comma-separated" << endl
        << "  -g  size histogram granularity (default 0 meaning no histogram)"
        << endl
@@ -324,7 +736,7 @@ void help() {
 void read_configuration(int argc, char **argv) {
   while (1) {
     i = 0;
-    c = getopt(argc, argv, "bcD:g:hi:k:m:o:r:s:t:u:v:w:x:z:");
+    c = getopt(argc, argv, "A:bBcC:d:D:eg:G:hi:j:k:m:o:Q:r:s:t:T:u:U:v:VW:w:x:z:");
 
     if (c == -1)
       break;
@@ -350,6 +762,8 @@ void read_configuration(int argc, char **argv) {
         ds = NUMA_PQ_4;
       else if (choice == "smq")
         ds = SMQ;
+      else if (choice == "delta")
+        ds = DELTA;
       else {
         std::string msg = "Invalid data structure: ";
         msg += std::to_string(ds);
@@ -357,12 +771,36 @@ void read_configuration(int argc, char **argv) {
       }
       break;
     }
+    case 'A': {
+      const std::string_view choice(optarg);
+      if (choice == "sssp")
+        app = APP_SSSP;
+      else if (choice == "astar")
+        app = APP_ASTAR;
+      else if (choice == "prim")
+        app = APP_PRIM;
+      else {
+        std::string msg = "Invalid application: ";
+        msg += optarg;
+        throw std::invalid_argument(msg);
+      }
+      break;
+    }
+    case 'd':
+      delta = atoi(optarg);
+      break;
     case 'w':
       max_weight = atoi(optarg);
       break;
     case 'b':
       bimodal = 1;
       break;
+    case 'B':
+      batch_relax = true;
+      break;
+    case 'Q':
+      nb_queries = atoi(optarg);
+      break;
     case 't':
       nb_threads = atoi(optarg);
       break;
@@ -378,6 +816,27 @@ void read_configuration(int argc, char **argv) {
     case 'v':
       verify_file = optarg;
       break;
+    case 'V':
+      dijkstra_check = true;
+      break;
+    case 'W':
+      work_interval_ms = atoi(optarg);
+      break;
+    case 'j':
+      json_output = optarg;
+      break;
+    case 'C':
+      csr_output = optarg;
+      break;
+    case 'G':
+      generator = optarg;
+      break;
+    case 'T':
+      trace_file = optarg;
+      break;
+    case 'e':
+      rank_error = true;
+      break;
     case 'r':
       reduced_file = optarg;
       break;
@@ -396,6 +855,9 @@ void read_configuration(int argc, char **argv) {
     case 'u':
       src = atoi(optarg);
       break;
+    case 'U':
+      target = atoi(optarg);
+      break;
     case 'x':
       counter_tsh = atoi(optarg);
       break;
@@ -423,17 +885,52 @@ void read_configuration(int argc, char **argv) {
     key_histogram = new size_t[key_histogram_size]();
   }
 
+  if (strcmp(generator, "") && (strcmp(input, "") || max_levels != -1))
+    throw std::invalid_argument("-G generates the graph; it cannot be "
+                                "combined with -i or -m");
+
+  if (batch_relax && ds != NUMA_PQ && ds != SMQ) {
+    printf("Batched relaxation (-B) is only available with numa_pq_lin and "
+           "smq.\n");
+    batch_relax = false;
+  }
+
+  if (app != APP_SSSP &&
+      (ds == DELTA || strcmp(verify_file, "") || dijkstra_check))
+    throw std::invalid_argument("A* and Prim run on the priority queues and "
+                                "check themselves against a sequential run "
+                                "(no -D delta, no -v or -V)");
+
+  if (nb_queries < 0)
+    throw std::invalid_argument("The number of queries (-Q) must be positive");
+
+  if (nb_queries > 0 &&
+      (app != APP_SSSP || ds == DELTA || strcmp(trace_file, "") ||
+       rank_error || strcmp(reduced_file, "")))
+    throw std::invalid_argument("A query stream (-Q) runs SSSP on the "
+                                "priority queues (no -A, -D delta, -T, -e or "
+                                "-r)");
+
+  if (work_interval_ms < 0)
+    throw std::invalid_argument("The work interval (-W) must be positive");
+
+  if (ds == DELTA && (strcmp(trace_file, "") || rank_error || work_interval_ms))
+    throw std::invalid_argument("Delta-stepping has no queue operations to "
+                                "trace (-T, -e, -W)");
+
   if (output_csv && !strcmp(verify_file, "") && !strcmp(output, ""))
     printf("Warning: Using CSV output with no output or verify file "
            "provided! If you're using CSV output, you're probably collecting "
            "data, and collected data should be verified for correctness!\n");
 }
 
+const char *graph_name() { return strcmp(generator, "") ? generator : input; }
+
 /// Prints the configuration prior to the operation.
 void print_configuration() {
   if (output_csv) {
     std::cout << "(bDimstuw)," << bimodal << "," << to_string(ds) << ","
-              << input << "," << max_levels << "," << seed << "," << nb_threads << ","
+              << graph_name() << "," << max_levels << "," << seed << "," << nb_threads << ","
               << src << "," << max_weight;
   } else {
     printf("Set type             : skip list\n");
@@ -446,134 +943,278 @@ void print_configuration() {
   }
 }
 
-void build_graph() {
-  FILE *fp = fopen(input, "r");
-  if (fp == nullptr) {
-    std::string msg = "Couldn't open file: ";
-    msg += input;
-    throw std::invalid_argument(msg);
+/// Draws the weight of the next edge, in edge-list order.
+int draw_weight() {
+  if (max_weight > 1) {
+    return (rand() % max_weight) + 1;
+  } else if (bimodal) {
+    if (rand() % 2) {
+      return (rand() % 11) + 20;
+    } else {
+      return (rand() % 11) + 70;
+    }
   }
+  return 1;
+}
 
-  int res = fscanf(fp, "# Nodes: %d Edges: %d\n", &nb_nodes, &nb_edges);
-  if (res != 2) {
-    std::string msg = "Invalid result code from fscanf(): ";
-    msg += std::to_string(res);
-    fclose(fp);
-    throw std::runtime_error(msg);
+void build_graph() {
+  if (strcmp(generator, "")) {
+    // seeded through rand() so -s 0 gives a time-based graph too
+    gen_graph(generator, rand(), nb_threads, {max_weight, bimodal}, graph);
+  } else if (csr_is_binary(input)) {
+    // zero-copy: the adjacency arrays point into the mapped file
+    csr_map(input, graph);
+    if (max_levels != -1 && (uint64_t)max_levels < graph.nb_nodes) {
+      std::string msg = "-m applies when converting a graph; convert again "
+                        "with -m to use fewer nodes of ";
+      msg += input;
+      throw std::invalid_argument(msg);
+    }
+    if ((max_weight > 1 || bimodal) && !output_csv)
+      printf("Edge weights are read from the CSR graph; -w and -b only apply "
+             "when converting\n");
+  } else {
+    csr_parse_text(input, max_levels, nb_threads, graph, draw_weight);
   }
-  if (nb_nodes > max_levels && max_levels != -1)
-    nb_nodes = max_levels;
+  nb_nodes = graph.nb_nodes;
+  nb_edges = graph.nb_edges;
 
-#ifndef STATIC
-  if ((nodes = (graph_node_t *)malloc(nb_nodes * sizeof(graph_node_t))) ==
-      NULL) {
+  if ((dist = (slkey_t *)numa_alloc_interleaved(nb_nodes * sizeof(slkey_t))) ==
+          NULL ||
+      (times_processed = (int *)malloc(nb_nodes * sizeof(int))) == NULL) {
     perror("malloc");
     exit(1);
   }
-#endif
-
-  for (i = 0; i < nb_nodes; i++) {
-    nodes[i].deg = 0;
-    nodes[i].dist = -1;
-    nodes[i].times_processed = 0;
-  }
 
-  int u, v;
-  while (fscanf(fp, "%d %d\n", &u, &v) == 2) {
-    //printf("u,v: %d %d\n", u, v);
-    if (u >= nb_nodes)
-      continue;
-    if (v >= nb_nodes)
-      continue;
-    nodes[u].deg++;
+  for (uint64_t u = 0; u < nb_nodes; u++) {
+    dist[u] = -1;
+    times_processed[u] = 0;
   }
 
-#ifndef STATIC
-  for (i = 0; i < nb_nodes; i++) {
-    if ((nodes[i].adj = (int *)malloc(nodes[i].deg * sizeof(int))) == NULL) {
-      perror("malloc");
-      exit(1);
-    }
-    if ((nodes[i].weights = (int *)malloc(nodes[i].deg * sizeof(int))) ==
-        NULL) {
-      perror("malloc");
-      exit(1);
-    }
-  }
-#endif
-  fclose(fp);
-
   if (src == -1) {
     // If src is set to default value, -1, determine source node automatically.
     // We use the first node (starting from 0) with out-degree > 0.
     do {
       ++src;
-    } while (src < nb_nodes && nodes[src].deg == 0);
+    } while ((uint64_t)src < nb_nodes && degree(src) == 0);
 
-    if (src == nb_nodes) {
+    if ((uint64_t)src == nb_nodes) {
       // Seems pretty pointless to run SSSP on a graph with no edges at all,
       // but whatever, let 'em do it.
       src = 0;
     }
   }
 
-  if (src < 0 || src >= nb_nodes) {
+  if (src < 0 || (uint64_t)src >= nb_nodes) {
     std::string msg = "Source node out of range. Index: ";
-    msg += src;
+    msg += std::to_string(src);
     msg += ", Number of nodes: ";
-    msg += nb_nodes;
+    msg += std::to_string(nb_nodes);
     throw std::invalid_argument(msg);
   }
 
   if (!output_csv)
     printf("Source node index    : %d\n", src);
 
-  nodes[src].dist = 0;
+  dist[src] = 0;
+}
+
+double elapsed_ms(const struct timeval &from, const struct timeval &to) {
+  return (to.tv_sec - from.tv_sec) * 1000.0 +
+         (to.tv_usec - from.tv_usec) / 1000.0;
+}
+
+/// Checks dist against a sequential radix heap Dijkstra from src on the same
+/// graph, comparing the two in parallel.
+void verify_dijkstra() {
+  if (!dijkstra_check)
+    return;
+  if (!output_csv)
+    printf("Running sequential Dijkstra...\n");
+
+  struct timeval begin, solved, compared;
+  gettimeofday(&begin, NULL);
+  std::vector<uint64_t> ref;
+  radix_dijkstra(graph, src, ref, &sequential_work);
+  gettimeofday(&solved, NULL);
+
+  std::vector<long> mismatches(nb_threads, 0);
+  std::vector<int> first(nb_threads, -1);
+  gen_parallel(nb_nodes, nb_threads, [&](int t, uint64_t begin, uint64_t end) {
+    for (uint64_t u = begin; u < end; u++) {
+      if (dist[u] != ref[u] && mismatches[t]++ == 0)
+        first[t] = u;
+    }
+  });
+  gettimeofday(&compared, NULL);
+
+  dijkstra_ms = elapsed_ms(begin, solved);
+  dijkstra_compare_ms = elapsed_ms(solved, compared);
+  dijkstra_mismatches = 0;
+  int first_wrong = -1;
+  for (int t = 0; t < nb_threads; t++) {
+    dijkstra_mismatches += mismatches[t];
+    if (first_wrong == -1)
+      first_wrong = first[t];
+  }
+  verify_status = dijkstra_mismatches ? "mismatch" : "ok";
+  if (!output_csv)
+    printf("Dijkstra check       : %ld mismatches (Dijkstra %.1f ms, compare "
+           "%.1f ms)\n",
+           dijkstra_mismatches, dijkstra_ms, dijkstra_compare_ms);
+  if (dijkstra_mismatches)
+    printf("Distances do not match the sequential Dijkstra! Node %d: %lu, "
+           "expected %lu\n",
+           first_wrong, dist[first_wrong], ref[first_wrong]);
+}
 
-  fp = fopen(input, "r");
-  if (fp == nullptr) {
-    std::string msg = "Couldn't open file: ";
-    msg += input;
+/// Sets up A*'s target and heuristic.
+void init_application() {
+  if (app != APP_ASTAR)
+    return;
+  long long rows;
+  if (!strcmp(generator, "") || !gen_grid_dims(generator, rows, grid_cols))
+    throw std::invalid_argument("A* needs a grid graph (-G grid:...)");
+  if (target == -1)
+    target = nb_nodes - 1;
+  if (target < 0 || (uint64_t)target >= nb_nodes) {
+    std::string msg = "Target node out of range. Index: ";
+    msg += std::to_string(target);
     throw std::invalid_argument(msg);
   }
-  int tmp;
-  res = fscanf(fp, "# Nodes: %d Edges: %d\n", &tmp, &nb_edges);
-  if (res != 2) {
-    std::string msg = "Invalid result code from fscanf(): ";
-    msg += std::to_string(res);
-    throw std::runtime_error(msg);
+  min_edge_weight = nb_edges ? (slkey_t)-1 : 0;
+  for (uint64_t e = 0; e < nb_edges; e++)
+    if ((slkey_t)graph.edges[e].weight < min_edge_weight)
+      min_edge_weight = graph.edges[e].weight;
+  if (!output_csv)
+    printf("A* target            : %d\n", target);
+}
+
+/// Checks A* and Prim against a sequential run (after the timed part).
+void verify_application() {
+  if (app == APP_SSSP)
+    return;
+  std::vector<slkey_t> ref(nb_nodes, (slkey_t)-1);
+  std::vector<char> done(nb_nodes, 0);
+  std::priority_queue<std::pair<slkey_t, int>,
+                      std::vector<std::pair<slkey_t, int>>,
+                      std::greater<std::pair<slkey_t, int>>>
+      queue;
+  slkey_t tree_weight = 0;
+  ref[src] = 0;
+  queue.push({0, src});
+  while (!queue.empty()) {
+    auto [key, u] = queue.top();
+    queue.pop();
+    if (done[u] || key != ref[u])
+      continue;
+    done[u] = 1;
+    tree_weight += (app == APP_PRIM ? key : 0);
+    if (app == APP_ASTAR && u == target)
+      break;
+    for (uint64_t j = graph.offsets[u]; j < graph.offsets[u + 1]; j++) {
+      int v = graph.edges[j].target;
+      slkey_t newkey = graph.edges[j].weight + (app == APP_PRIM ? 0 : key);
+      if (!done[v] && newkey < ref[v]) {
+        ref[v] = newkey;
+        queue.push({newkey, v});
+      }
+    }
   }
 
-  int *idx;
-  if ((idx = (int *)malloc(nb_nodes * sizeof(int))) == NULL) {
-    perror("malloc");
-    exit(1);
+  bool ok;
+  if (app == APP_ASTAR) {
+    app_reference = ref[target];
+    app_result = dist[target];
+    ok = (app_result == app_reference);
+    verify_status = ok ? "ok" : "mismatch";
+    if (!output_csv)
+      printf("Path length          : %lu (sequential: %lu)\n", app_result,
+             app_reference);
+  } else {
+    app_reference = tree_weight;
+    app_result = 0;
+    for (int t = 0; t < nb_threads; t++)
+      app_result += thread_data[t].tree_weight;
+    long spanned = 0, ref_spanned = 0;
+    for (uint64_t u = 0; u < nb_nodes; u++) {
+      spanned += (times_processed[u] != 0);
+      ref_spanned += done[u];
+    }
+    ok = (spanned == ref_spanned && app_result >= app_reference);
+    verify_status = !ok                           ? "mismatch"
+                    : app_result == app_reference ? "ok"
+                                                  : "suboptimal";
+    if (!output_csv)
+      printf("Tree weight          : %lu (minimum: %lu, +%.3f%%), %ld of %ld "
+             "nodes\n",
+             app_result, app_reference,
+             app_reference ? 100.0 * ((double)app_result - app_reference) /
+                                 app_reference
+                           : 0.0,
+             spanned, ref_spanned);
   }
-  for (i = 0; i < nb_nodes; i++) {
-    idx[i] = 0;
+  if (!ok)
+    printf("A* / Prim result does not match the sequential run!\n");
+}
+
+/// Seeds a query from src: sets its dist and inserts it into the queues that
+/// take inserts from the main thread (thread 0 seeds the others, see
+/// insert_source_local).
+void insert_source() {
+  slkey_t start_key = 0;
+  if (ds == LINDEN) {
+    start_key = 1; // account for the fact that keys must be positive
+    insert(linden_set, start_key + heuristic(src), src);
+  } else if (ds == LOTAN || ds == SPRAY) {
+    sl_add_val(set_ds, start_key + heuristic(src), src, TRANSACTIONAL);
   }
+  if (trace_recorder && (ds == LINDEN || ds == LOTAN || ds == SPRAY))
+    trace_recorder->record(0, PQ_TRACE_INSERT, start_key + heuristic(src), src);
 
-  while (fscanf(fp, "%d %d\n", &u, &v) == 2) {
-    if (u >= nb_nodes)
-      continue;
-    if (v >= nb_nodes)
-      continue;
-    assert(idx[u] < nodes[u].deg);
-    nodes[u].adj[idx[u]] = v;
-    if (max_weight > 1) {
-      nodes[u].weights[idx[u]] = (rand() % max_weight) + 1;
-    } else if (bimodal) {
-      if (rand() % 2) {
-        nodes[u].weights[idx[u]] = (rand() % 11) + 20;
-      } else {
-        nodes[u].weights[idx[u]] = (rand() % 11) + 70;
-      }
-    } else {
-      nodes[u].weights[idx[u]] = 1;
+  dist[src] = start_key;
+  max_inserted_key = start_key;
+  if (key_histogram_size > start_key) {
+    key_histogram[start_key]++;
+  }
+}
+
+/// Draws the sources of a -Q stream up front: the first query runs from src,
+/// the others from random nodes with out-degree > 0. They come from their own
+/// generator, seeded by -s, so they do not depend on the number of threads
+/// (each thread's seeds are drawn from rand()).
+void draw_query_sources() {
+  std::mt19937_64 rng(seed == 0 ? (int)time(0) : seed);
+  query_sources.assign(std::max(nb_queries, 1), src);
+  if (nb_edges == 0)
+    return;
+  for (int query = 1; query < nb_queries; query++) {
+    do {
+      query_sources[query] = rng() % nb_nodes;
+    } while (degree(query_sources[query]) == 0);
+  }
+}
+
+/// Readies the given query of a -Q stream while the threads wait: resets the
+/// nodes the last query reached and seeds the query's source.
+void next_query(int query) {
+  for (int t = 0; t < nb_threads; t++) {
+    for (int v : dirty[t]) {
+      dist[v] = -1;
+      times_processed[v] = 0;
     }
-    idx[u]++;
+    dirty[t].clear();
+    pending[t].pushed = (t == 0);
+    pending[t].finished = 0;
   }
-  free(idx);
+  dist[src] = -1;
+  times_processed[src] = 0;
+
+  src = query_sources[query];
+  if (ds == NUMA_PQ)
+    numa_pq_ds->clear();
+  sssp_done = false;
+  insert_source();
 }
 
 /// Performs data-structure-specific initialization.
@@ -591,8 +1232,6 @@ void init_data_structure() {
   // of the same chunk should be fine.)
   //cfg.nteams = MAX_TEAMS_T;
 
-  slkey_t start_key = 0;
-
   switch (ds) {
   case NUMA_PQ: {
     int heap_list_size = 50000000;
@@ -619,19 +1258,32 @@ void init_data_structure() {
     smq_ds = new smq_t(nb_threads);
     break;
   }
+  case DELTA: {
+    max_edge_weight = 1;
+    for (uint64_t u = 0; u < nb_nodes; u++)
+      for (uint64_t j = graph.offsets[u]; j < graph.offsets[u + 1]; j++)
+        if ((slkey_t)graph.edges[j].weight > max_edge_weight)
+          max_edge_weight = graph.edges[j].weight;
+    if (delta == 0)
+      delta = nb_edges ? max_edge_weight * nb_nodes / nb_edges : 1;
+    if (delta == 0)
+      delta = 1;
+    frontier_offsets = new size_t[nb_threads];
+    next_bucket[0] = next_bucket[1] = (uint64_t)-1;
+    if (!output_csv)
+      printf("Delta                : %lu\n", delta);
+    break;
+  }
     
   case LINDEN: {
     int offset = 32; // not sure what this does
     _init_gc_subsystem();
     linden_set = pq_init(offset);
-    start_key = 1; // account for the fact that keys must be positive
-    insert(linden_set, start_key, src);
     break;
   }
   case LOTAN:
   case SPRAY: {
     set_ds = sl_set_new();
-    sl_add_val(set_ds, start_key, src, TRANSACTIONAL);
     break;
   }
 
@@ -640,12 +1292,7 @@ void init_data_structure() {
     break;
   }
 
-  // Further initialization
-  nodes[src].dist = start_key;
-  max_inserted_key = start_key;
-  if (key_histogram_size > start_key) {
-    key_histogram[start_key]++;
-  }
+  insert_source();
 }
 
 void reduce_graph() {
@@ -653,8 +1300,8 @@ void reduce_graph() {
     return;
 
   // Go through all nodes. If times_processed is positive, it was reached, so we
-  // assign it a new index number. To avoid having this functionality increase
-  // the size of the node struct and therefore significantly increase the memory
+  // assign it a new index number. To avoid having this functionality add
+  // another per-node array and therefore significantly increase the memory
   // footprint, we write the new index directly back to times_processed, a value
   // we no longer need. If times_processed is 0, it wasn't reached, so it
   // will be removed from the reduced file; the flag -1 indicates this.
@@ -662,34 +1309,36 @@ void reduce_graph() {
   std::cout << "Beginning initial scan for graph reduction." << std::endl;
 
   int reachable_nodes = 0;
-  int reachable_edges = 0;
-  for (int i = 0; i < nb_nodes; ++i) {
-    if (nodes[i].times_processed > 0) {
-      nodes[i].times_processed = reachable_nodes++;
-      reachable_edges += nodes[i].deg;
+  uint64_t reachable_edges = 0;
+  for (uint64_t i = 0; i < nb_nodes; ++i) {
+    if (times_processed[i] > 0) {
+      times_processed[i] = reachable_nodes++;
+      reachable_edges += degree(i);
     } else {
-      nodes[i].times_processed = -1;
+      times_processed[i] = -1;
     }
   }
 
   // Write the file header
   FILE *out = fopen(reduced_file, "w");
-  fprintf(out, "# Nodes: %d Edges: %d\n", reachable_nodes, reachable_edges);
+  fprintf(out, "# Nodes: %d Edges: %" PRIu64 "\n", reachable_nodes,
+          reachable_edges);
 
-  printf("Reachable Nodes: %d Edges: %d\n", reachable_nodes, reachable_edges);
+  printf("Reachable Nodes: %d Edges: %" PRIu64 "\n", reachable_nodes,
+         reachable_edges);
   printf("Source Node's New Index (SAVE THIS): %d\n",
-         nodes[src].times_processed);
+         times_processed[src]);
 
   // Go through the graph and write all the edges from living nodes to the file.
-  for (int i = 0; i < nb_nodes; ++i) {
-    int const new_idx = nodes[i].times_processed;
+  for (uint64_t i = 0; i < nb_nodes; ++i) {
+    int const new_idx = times_processed[i];
 
     if (new_idx < 0)
       continue;
 
-    for (int j = 0; j < nodes[i].deg; ++j) {
-      int const dest_idx = nodes[i].adj[j];
-      int const new_dest_idx = nodes[dest_idx].times_processed;
+    for (uint64_t j = graph.offsets[i]; j < graph.offsets[i + 1]; ++j) {
+      int const dest_idx = graph.edges[j].target;
+      int const new_dest_idx = times_processed[dest_idx];
       fprintf(out, "%d %d\n", new_idx, new_dest_idx);
     }
   }
@@ -715,10 +1364,8 @@ void print_results() {
       if (!output_csv)
         cout << "Writing output..." << endl;
 
-      for (int i = 0; i < nb_nodes; i++) {
-        if (ds == LINDEN && nodes[i].dist != 0xFFFFFFFFFFFFFFFF)
-          nodes[i].dist--;
-        fprintf(out, "%d %lu\n", i, nodes[i].dist);
+      for (uint64_t i = 0; i < nb_nodes; i++) {
+        fprintf(out, "%" PRIu64 " %lu\n", i, dist[i]);
       }
       fclose(out);
     }
@@ -731,6 +1378,7 @@ void print_results() {
     FILE *vf = fopen(verify_file, "r");
     if (vf == nullptr) {
       cout << "Couldn't open verify file: " << verify_file << endl;
+      verify_status = "unreadable";
     } else {
       if (!output_csv)
         cout << "Performing verification..." << endl;
@@ -757,19 +1405,17 @@ void print_results() {
           throw std::logic_error(msg);
         }
 
-        if (ds == LINDEN && nodes[i].dist != 0xFFFFFFFFFFFFFFFF)
-          nodes[i].dist--;
-
-        if (v != nodes[i].dist) {
+        if (v != dist[i]) {
           std::string msg = "For node index ";
           msg += std::to_string(i);
           msg += ", the computed distance was wrong. Expected: ";
           msg += std::to_string(v);
           msg += ", Actual: ";
-          msg += std::to_string(nodes[i].dist);
+          msg += std::to_string(dist[i]);
           throw std::logic_error(msg);
         }
       }
+      verify_status = "ok";
       if (!output_csv)
         printf("Verification successful!\n");
     }
@@ -782,7 +1428,7 @@ void print_results() {
   //   // No output, verify, or reduce file was provided, and we are not in CSV
   //   // output mode, so fall back on the default behavior: print the results.
   //   for (int i = 0; i < nb_nodes; i++) {
-  //     printf("%d %lu\n", i, nodes[i].dist);
+  //     printf("%d %lu\n", i, dist[i]);
   //   }
   // }
 }
@@ -799,6 +1445,8 @@ unsigned long get_set_size() {
     return (unsigned long)numa_pq_4_ds->getSize();
   case SMQ:
     return (unsigned long)smq_ds->getSize();
+  case DELTA:
+    return 0; // every bucket is empty once the threads stop
   case LINDEN: {
     // [mar] Destructively determine the size of the set by emptying it.
     // For how this method is used, this is fine.
@@ -816,6 +1464,11 @@ unsigned long get_set_size() {
   }
 }
 
+/// Latency percentile of the -Q queries (query_ms is sorted by then).
+double query_percentile(int p) {
+  return query_ms.empty() ? 0.0 : query_ms[(query_ms.size() - 1) * p / 100];
+}
+
 /// Prints the statistics from the SSSP operation.
 void print_stats() {
 
@@ -825,14 +1478,14 @@ void print_stats() {
 
   long nb_processed = 0;
   long unreachable = 0;
-  for (int i = 0; i < nb_nodes; i++) {
-    nb_processed += nodes[i].times_processed;
-    if (nodes[i].times_processed == 0) {
+  for (uint64_t i = 0; i < nb_nodes; i++) {
+    nb_processed += times_processed[i];
+    if (times_processed[i] == 0) {
       unreachable++;
     }
   }
 
-  long wasted_work = nb_processed - (nb_nodes - unreachable);
+  long wasted_work = nb_processed - ((long)nb_nodes - unreachable);
   int duration = (end_time.tv_sec * 1000 + end_time.tv_usec / 1000) -
                  (start.tv_sec * 1000 + start.tv_usec / 1000);
 
@@ -841,17 +1494,21 @@ void print_stats() {
 
   effreads = 0;
   updates = 0;
-  nb_insertions =
-      1; // [mar] This accounts for initial insertion of the source node
+  // [mar] This accounts for initial insertion of the source node (of each
+  // query)
+  nb_insertions = std::max(nb_queries, 1);
   nb_removals = 0;
   nb_removed = 0;
   effupds = 0;
+  unsigned long nb_reprocessed = 0, nb_relaxations = 0, nb_redundant = 0;
   for (i = 0; i < nb_threads; i++) {
     if (!output_csv) {
       printf("Thread %d\n", i);
       printf("  #insertions        : %lu\n", thread_data[i].nb_insertions);
+      printf("    #redundant       : %lu\n", thread_data[i].nb_redundant);
       printf("  #removals          : %lu\n", thread_data[i].nb_removals);
       printf("    #alive           : %lu\n", thread_data[i].nb_removed);
+      printf("      #reprocessed   : %lu\n", thread_data[i].nb_reprocessed);
       printf("    #dead            : %lu\n", thread_data[i].nb_dead_nodes);
       printf("    #empty           : %lu\n",
              thread_data[i].nb_removals - thread_data[i].nb_removed - thread_data[i].nb_dead_nodes);
@@ -863,6 +1520,33 @@ void print_stats() {
     nb_removed += thread_data[i].nb_removed;
     nb_dead_nodes += thread_data[i].nb_dead_nodes;
     effupds += thread_data[i].nb_insertions + thread_data[i].nb_removed;
+    nb_reprocessed += thread_data[i].nb_reprocessed;
+    nb_relaxations += thread_data[i].nb_relaxations;
+    nb_redundant += thread_data[i].nb_redundant;
+  }
+
+  // the work a sequential Dijkstra needs for the same query (-V), which the
+  // queue's pops, relaxations and inserts are normalized by
+  bool work_ratios = dijkstra_check && nb_queries == 0;
+  auto ratio = [](unsigned long work, uint64_t sequential) {
+    return sequential ? (double)work / sequential : 0.0;
+  };
+
+  // merge the threads' work intervals
+  std::vector<work_interval> timeline;
+  for (int t = 0; work_timeline && t < nb_threads; t++) {
+    const std::vector<work_interval> &intervals = work_timeline[t].intervals;
+    if (timeline.size() < intervals.size())
+      timeline.resize(intervals.size(), work_interval());
+    for (size_t ix = 0; ix < intervals.size(); ix++) {
+      const work_interval &w = intervals[ix];
+      timeline[ix].alive += w.alive;
+      timeline[ix].dead += w.dead;
+      timeline[ix].empty += w.empty;
+      timeline[ix].reprocessed += w.reprocessed;
+      timeline[ix].inserts += w.inserts;
+      timeline[ix].redundant += w.redundant;
+    }
   }
 
   if (!output_csv) {
@@ -874,6 +1558,14 @@ void print_stats() {
     printf("Duration             : %d (ms)\n", duration);
     printf("#ops                 : %lu (%f / s)\n", updates,
            (updates)*1000.0 / duration);
+    if (nb_queries > 0) {
+      printf("#queries             : %d (%f / s)\n", nb_queries,
+             nb_queries * 1000.0 / duration);
+      printf("query latency (ms)   : p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+             query_percentile(50), query_percentile(90),
+             query_percentile(99), query_percentile(100));
+      printf("last query source    : %d\n", src);
+    }
 
     printf("#eff. upd rate       : %f \n",
            100.0 * effupds / (effupds + effreads));
@@ -889,9 +1581,44 @@ void print_stats() {
     printf("#total insertions    : %lu\n", nb_insertions);
     printf("#net (ins. - rem.)   : %lu\n",
            nb_insertions - nb_removed - nb_dead_nodes);
+    if (ds != DELTA) {
+      printf("Work                 : %lu useful pops, %lu wasted (%lu dead, "
+             "%lu empty, %lu reprocessed)\n",
+             nb_removed - nb_reprocessed,
+             nb_removals - nb_removed + nb_reprocessed, nb_dead_nodes,
+             nb_removals - nb_removed - nb_dead_nodes, nb_reprocessed);
+      printf("   #reprocessed      : %lu\n", nb_reprocessed);
+      printf("   #relaxations      : %lu\n", nb_relaxations);
+      printf("   #redundant inserts: %lu\n", nb_redundant);
+    }
+    if (ds != DELTA && work_ratios) {
+      printf("Work / Dijkstra's    : pops %.3f, relaxations %.3f, inserts "
+             "%.3f\n",
+             ratio(nb_removals, sequential_work.pops),
+             ratio(nb_relaxations, sequential_work.relaxations),
+             ratio(nb_insertions, sequential_work.inserts));
+    }
+    if (!timeline.empty()) {
+      printf("work timeline (ms, alive, reprocessed, dead, empty, inserts, "
+             "redundant):\n");
+      for (size_t ix = 0; ix < timeline.size(); ix++) {
+        const work_interval &w = timeline[ix];
+        printf("  %lu, %lu, %lu, %lu, %lu, %lu, %lu\n", ix * work_interval_ms,
+               w.alive, w.reprocessed, w.dead, w.empty, w.inserts,
+               w.redundant);
+      }
+    }
     if (nb_threads == 1) {
       printf("Nontail insertions   : %lu\n", nb_nontail_insertions);
     }
+    if (rank_error) {
+      printf("rank error mean      : %f\n", rank_stats.rank_mean);
+      printf("rank error p50/p90/p99/max : %lld / %lld / %lld / %lld\n",
+             rank_stats.rank_p50, rank_stats.rank_p90, rank_stats.rank_p99,
+             rank_stats.rank_max);
+      printf("delay mean/max       : %f / %lld\n", rank_stats.delay_mean,
+             rank_stats.delay_max);
+    }
   }
 
   if (key_histogram_size > 0) {
@@ -907,6 +1634,109 @@ void print_stats() {
     std::cout << ",(dur wasted)," << duration << "," << wasted_work
               << std::endl;
   }
+
+  if (strcmp(json_output, "")) {
+    json_record config, results, record;
+    config.add("app", to_string(app)).add("ds", to_string(ds)).add("input", graph_name()).add("threads", nb_threads)
+        .add("seed", seed).add("src", src).add("max_weight", max_weight)
+        .add("bimodal", bimodal).add("max_levels", max_levels)
+        .add("counter_tsh", counter_tsh).add("counter_max", counter_max)
+        .add("batch_relax", batch_relax);
+    if (ds == DELTA)
+      config.add("delta", delta);
+    if (app == APP_ASTAR)
+      config.add("target", target);
+    results.add("duration_ms", duration).add("ops", updates)
+        .add("ops_per_sec", duration ? updates * 1000.0 / duration : 0.0)
+        .add("nodes", nb_nodes).add("nodes_processed", nb_processed)
+        .add("unreachable", unreachable).add("wasted_work", wasted_work)
+        .add("insertions", nb_insertions).add("removals", nb_removals)
+        .add("removals_alive", nb_removed).add("removals_dead", nb_dead_nodes)
+        .add("removals_empty", nb_removals - nb_removed - nb_dead_nodes);
+    if (app != APP_SSSP)
+      results.add(app == APP_ASTAR ? "path_length" : "tree_weight", app_result)
+          .add(app == APP_ASTAR ? "path_length_sequential" : "tree_weight_min",
+               app_reference);
+    if (ds != DELTA) {
+      json_record work;
+      work.add("useful_pops", nb_removed - nb_reprocessed)
+          .add("wasted_pops", nb_removals - nb_removed + nb_reprocessed)
+          .add("reprocessed", nb_reprocessed)
+          .add("relaxations", nb_relaxations)
+          .add("redundant_inserts", nb_redundant);
+      if (work_ratios) {
+        json_record sequential;
+        sequential.add("pops", sequential_work.pops)
+            .add("settled", sequential_work.settled)
+            .add("relaxations", sequential_work.relaxations)
+            .add("inserts", sequential_work.inserts);
+        work.add("dijkstra", sequential)
+            .add("pops_ratio", ratio(nb_removals, sequential_work.pops))
+            .add("relaxations_ratio",
+                 ratio(nb_relaxations, sequential_work.relaxations))
+            .add("inserts_ratio", ratio(nb_insertions, sequential_work.inserts));
+      }
+      if (!timeline.empty()) {
+        std::vector<unsigned long> alive, reprocessed, dead, empty, inserts,
+            redundant;
+        for (const work_interval &w : timeline) {
+          alive.push_back(w.alive);
+          reprocessed.push_back(w.reprocessed);
+          dead.push_back(w.dead);
+          empty.push_back(w.empty);
+          inserts.push_back(w.inserts);
+          redundant.push_back(w.redundant);
+        }
+        json_record intervals;
+        intervals.add("interval_ms", work_interval_ms).add("alive", alive)
+            .add("reprocessed", reprocessed).add("dead", dead)
+            .add("empty", empty).add("inserts", inserts)
+            .add("redundant", redundant);
+        work.add("timeline", intervals);
+      }
+      results.add("work", work);
+    }
+    if (dijkstra_check) {
+      json_record check;
+      check.add("mismatches", dijkstra_mismatches)
+          .add("dijkstra_ms", dijkstra_ms)
+          .add("compare_ms", dijkstra_compare_ms);
+      results.add("dijkstra_check", check);
+    }
+    if (nb_queries > 0) {
+      json_record queries;
+      queries.add("count", nb_queries)
+          .add("per_sec", duration ? nb_queries * 1000.0 / duration : 0.0)
+          .add("p50_ms", query_percentile(50))
+          .add("p90_ms", query_percentile(90))
+          .add("p99_ms", query_percentile(99))
+          .add("max_ms", query_percentile(100))
+          .add("last_src", src);
+      results.add("queries", queries);
+    }
+    if (ds == NUMA_PQ) {
+      json_record paths;
+      paths.add("moves", numa_pq_ds->getTotalMoves())
+          .add("fast", numa_pq_ds->getTotalFastPath())
+          .add("insert_up", numa_pq_ds->getTotalInsertUp());
+      results.add("pipq_paths", paths);
+    }
+    if (rank_error) {
+      json_record rank;
+      rank.add("delete_mins", rank_stats.delete_mins)
+          .add("unmatched", rank_stats.unmatched)
+          .add("mean", rank_stats.rank_mean).add("p50", rank_stats.rank_p50)
+          .add("p90", rank_stats.rank_p90).add("p99", rank_stats.rank_p99)
+          .add("max", rank_stats.rank_max)
+          .add("delay_mean", rank_stats.delay_mean)
+          .add("delay_max", rank_stats.delay_max);
+      results.add("rank_error", rank);
+    }
+    record.add("config", config).add("results", results)
+        .add("verification", verify_status);
+    if (!record.append_to(json_output))
+      printf("Couldn't write JSON results to %s\n", json_output);
+  }
 }
 
 int main(int argc, char **argv) {
@@ -951,13 +1781,41 @@ int main(int argc, char **argv) {
 
   build_graph();
 
+  if (strcmp(csr_output, "")) {
+    csr_write(csr_output, graph);
+    printf("Wrote %" PRIu64 " nodes and %" PRIu64 " edges to %s\n", nb_nodes,
+           nb_edges,
+           csr_output);
+    return 0;
+  }
+
+  if (strcmp(trace_file, "") || rank_error)
+    trace_recorder = new pq_trace_recorder(nb_threads, 1 << 16);
+
+  init_application();
+  draw_query_sources();
   init_data_structure();
 
   if (!output_csv) {
-    printf("Graph size           : %d\n", nb_nodes);
+    printf("Graph size           : %" PRIu64 "\n", nb_nodes);
     printf("Level max            : %d\n", *levelmax);
   }
 
+  // the source's insert (by main or by thread 0) is pending until it is relaxed
+  pending = new pending_counts[nb_threads];
+  for (int t = 0; t < nb_threads; t++) {
+    pending[t].pushed = (t == 0);
+    pending[t].finished = 0;
+  }
+
+  if (nb_queries > 0)
+    dirty = new std::vector<int>[nb_threads];
+  if (work_interval_ms > 0) {
+    work_timeline = new work_thread_timeline[nb_threads];
+    for (int t = 0; t < nb_threads; t++)
+      work_timeline[t].intervals.reserve(WORK_TIMELINE_RESERVE);
+  }
+
   // Access set from all threads
   barrier_init(&barrier, nb_threads + 1);
   // pthread_attr_init(&attr);
@@ -973,6 +1831,10 @@ int main(int argc, char **argv) {
     thread_data[i].first_remove = -1;
     thread_data[i].nb_insertions = 0;
     thread_data[i].nb_dead_nodes = 0;
+    thread_data[i].nb_reprocessed = 0;
+    thread_data[i].nb_relaxations = 0;
+    thread_data[i].nb_redundant = 0;
+    thread_data[i].tree_weight = 0;
     thread_data[i].nb_removals = 0;
     thread_data[i].nb_removed = 0;
     thread_data[i].nb_found = 0;
@@ -1007,7 +1869,8 @@ int main(int argc, char **argv) {
     //   fprintf(stderr, "Error creating thread\n");
     //   exit(1);
     // }
-    if (pthread_create(threads[i], NULL, sssp, (void *)(&thread_data[i])) != 0) {
+    if (pthread_create(threads[i], NULL, ds == DELTA ? delta_stepping : sssp,
+                       (void *)(&thread_data[i])) != 0) {
       fprintf(stderr, "Error creating thread\n");
       exit(1);
     }
@@ -1030,12 +1893,32 @@ int main(int argc, char **argv) {
   *running = 1;
 
   // Start threads
+  // Query stream: a query runs from the threads' start barrier to the one
+  // they cross when it is done; between the two, main resets and reseeds.
+  // Its clock starts before the barrier that releases the threads, so the
+  // first threads released cannot run ahead of it
+  struct timeval query_start, query_end;
+  work_start = std::chrono::steady_clock::now();
+  gettimeofday(&query_start, NULL);
   barrier_cross(&barrier);
 
   if (!output_csv)
     printf("STARTING...\n");
   gettimeofday(&start, NULL);
 
+  for (int query = 0; query < nb_queries; query++) {
+    barrier_cross(&barrier);
+    gettimeofday(&query_end, NULL);
+    query_ms.push_back(elapsed_ms(query_start, query_end));
+    if (query + 1 == nb_queries)
+      break;
+    next_query(query + 1);
+    barrier_cross(&barrier); // reset done; thread 0 seeds its own queues
+    gettimeofday(&query_start, NULL);
+    barrier_cross(&barrier);
+  }
+  std::sort(query_ms.begin(), query_ms.end());
+
   // Wait for thread completion
   for (i = 0; i < nb_threads; i++) {
     if (pthread_join(*(threads[i]), NULL) != 0) {
@@ -1048,10 +1931,33 @@ int main(int argc, char **argv) {
   if (!output_csv)
     printf("STOPPING...\n");
 
+  if (rank_error)
+    rank_stats = rank_error_analyze(*trace_recorder);
+
+  // Linden's keys must be positive, so its distances start at 1
+  if (ds == LINDEN) {
+    for (uint64_t i = 0; i < nb_nodes; i++) {
+      if (dist[i] != (slkey_t)-1)
+        dist[i]--;
+    }
+  }
+
   reduce_graph();
+  verify_application();
+  verify_dijkstra();
   print_results();
   print_stats();
 
+  if (trace_recorder) {
+    if (strcmp(trace_file, "")) { // otherwise only traced for the rank error
+      if (trace_recorder->write(trace_file))
+        printf("Recorded %lld operations to %s\n", trace_recorder->size(), trace_file);
+      else
+        printf("Couldn't write trace to %s\n", trace_file);
+    }
+    delete trace_recorder;
+  }
+
   // Delete set
   if (ds == SPRAY || ds == LOTAN) {
     sl_set_delete(set_ds);
@@ -1067,6 +1973,10 @@ int main(int argc, char **argv) {
   //free(threads);
   free(thread_data);
   delete[] key_histogram;
+  delete[] pending;
+  delete[] dirty;
+  delete[] work_timeline;
+  delete[] frontier_offsets;
 
   return 0;
 }
@@ -392,6 +392,7 @@ public:
 
   void initThread(int tid);
   unsigned int push(T elem);
+  unsigned int push(T const* elems, int n); // refills the steal buffer once for all n
   void pop(T* key);
 
   long del_wrapper(long* key);
@@ -88,6 +88,20 @@ unsigned int smq_ns::StealingMultiQueue<T, StealProb, StealBatchSize, Concurrent
     return 1;
   }
 
+template<typename T,
+         //typename Comparer,
+         size_t StealProb,
+         size_t StealBatchSize,
+         bool Concurrent>
+unsigned int smq_ns::StealingMultiQueue<T, StealProb, StealBatchSize, Concurrent>::push(T const* elems, int n) {
+    Heap* heap = &heaps[t_tid].heap;
+    for (int i = 0; i < n; i++) {
+      heap->pushLocally(elems[i]);
+    }
+    heap->fillBufferIfStolen();
+    return n;
+  }
+
 template<typename T,
          //typename Comparer,
          size_t StealProb,